@@ -0,0 +1,23 @@
+#include <stdexcept>
+#include "BakedDictionary.hpp"
+#ifdef SPAM_BAKED_DICTIONARY
+#include "BakedTables.hpp" //generated at build time by dict_bake
+#endif
+
+bool hasBakedDictionary()
+{
+#ifdef SPAM_BAKED_DICTIONARY
+    return true;
+#else
+    return false;
+#endif
+}
+
+PhraseMatcher bakedMatcher()
+{
+#ifdef SPAM_BAKED_DICTIONARY
+    return PhraseMatcher(BAKED_TABLES, nullptr); //the tables live as long as the program
+#else
+    throw std::invalid_argument(NO_BAKED_DICTIONARY_ERROR);
+#endif
+}
@@ -0,0 +1,23 @@
+#include <string>
+#include "PhraseMatcher.hpp"
+
+#ifndef EX3_BAKEDDICTIONARY_HPP
+#define EX3_BAKEDDICTIONARY_HPP
+
+#define BAKED_DATABASE_PATH "@baked"
+#define NO_BAKED_DICTIONARY_ERROR "No dictionary was compiled into this binary"
+
+/**
+ * @return true if a dictionary was compiled into this binary, false otherwise
+ */
+bool hasBakedDictionary();
+
+/**
+ * @brief builds a matcher over the tables compiled into this binary. they are read in place, so
+ * this reads no file and allocates nothing
+ * @return the matcher of the baked dictionary
+ * @throw std::invalid_argument if no dictionary was compiled into this binary
+ */
+PhraseMatcher bakedMatcher();
+
+#endif //EX3_BAKEDDICTIONARY_HPP
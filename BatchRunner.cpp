@@ -0,0 +1,140 @@
+#include <fstream>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include "BatchRunner.hpp"
+#include "WorkStealingPool.hpp"
+#include "MessageScanner.hpp"
+
+const size_t BATCH_WINDOW_PER_THREAD = 64;
+
+namespace
+{
+    /**
+     * @brief the verdicts of a batch run
+     */
+    enum BatchVerdict
+    {
+        VERDICT_PENDING, VERDICT_SPAM, VERDICT_NOT_SPAM, VERDICT_UNREADABLE
+    };
+}
+
+bool scoreBatch(const PhraseMatcher &matcher, MessageSource &messages, const BatchOptions &options,
+                std::ostream &out, RunStats &stats)
+{
+    int threshold = options.threshold;
+    //messages in flight are kept in a ring, so verdicts are written in input order while the
+    //workers keep going
+    size_t windowSize = options.threadCount * BATCH_WINDOW_PER_THREAD;
+    std::vector<std::string> paths(windowSize);
+    std::vector<BatchVerdict> verdicts(windowSize, VERDICT_PENDING);
+    std::vector<long> scores(windowSize);
+    std::mutex verdictsLock;
+    std::condition_variable verdictReady;
+    size_t head = 0;
+    size_t inFlight = 0;
+    bool allRead = true;
+    WorkStealingPool pool(options.threadCount);
+    //a large message is split between the workers that have nothing else to do
+    ParallelScanner parallel(matcher, pool, options.parallelCutoff);
+    while (true)
+    {
+        std::string messagePath;
+        //the queued messages use the scanner, which is destroyed before the pool, so if listing
+        //the messages fails they are waited for before the error leaves
+        try
+        {
+            while (inFlight < windowSize && messages.next(messagePath))
+            {
+                size_t slot = (head + inFlight) % windowSize;
+                paths[slot] = messagePath;
+                pool.submit([&, slot, messagePath](size_t workerIdx)
+                            {
+                                BatchVerdict verdict = VERDICT_UNREADABLE;
+                                long score = 0;
+                                try
+                                {
+                                    if (std::ifstream(messagePath))
+                                    {
+                                        PhraseMatcher::ScoreLimit limit(threshold);
+                                        score = scoreMessage(matcher, messagePath,
+                                                             parallel.scanState(workerIdx),
+                                                             options.fullScore ? nullptr : &limit,
+                                                             &parallel);
+                                        verdict = score >= threshold ? VERDICT_SPAM :
+                                                  VERDICT_NOT_SPAM;
+                                    }
+                                }
+                                catch (...)
+                                {
+                                    verdict = VERDICT_UNREADABLE;
+                                }
+                                std::lock_guard<std::mutex> guard(verdictsLock);
+                                scores[slot] = score;
+                                verdicts[slot] = verdict;
+                                verdictReady.notify_one();
+                            });
+                //counted once it's queued, so a failed submit is never waited for
+                inFlight++;
+            }
+        }
+        catch (...)
+        {
+            std::unique_lock<std::mutex> guard(verdictsLock);
+            verdictReady.wait(guard, [&]
+            {
+                for (size_t waited = 0; waited < inFlight; waited++)
+                {
+                    if (verdicts[(head + waited) % windowSize] == VERDICT_PENDING)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            });
+            throw;
+        }
+        if (inFlight == 0)
+        {
+            break;
+        }
+        BatchVerdict verdict;
+        {
+            std::unique_lock<std::mutex> guard(verdictsLock);
+            verdictReady.wait(guard, [&]
+            { return verdicts[head] != VERDICT_PENDING; });
+            verdict = verdicts[head];
+            verdicts[head] = VERDICT_PENDING;
+        }
+        out << paths[head] << VERDICT_SEPARATOR;
+        switch (verdict)
+        {
+            case VERDICT_SPAM:
+                out << SPAM_VERDICT;
+                break;
+            case VERDICT_NOT_SPAM:
+                out << NOT_SPAM_VERDICT;
+                break;
+            default:
+                out << UNREADABLE_VERDICT;
+                allRead = false;
+        }
+        if (options.fullScore && verdict != VERDICT_UNREADABLE)
+        {
+            out << VERDICT_SEPARATOR << scores[head];
+        }
+        out << '\n';
+        head = (head + 1) % windowSize;
+        inFlight--;
+        stats.addMessages(1);
+    }
+    out.flush();
+    for (const auto &scanState : parallel.scanStates())
+    {
+        if (scanState != nullptr)
+        {
+            stats.addScan(*scanState);
+        }
+    }
+    return allRead;
+}
@@ -0,0 +1,47 @@
+#include <string>
+#include <ostream>
+#include <cstddef>
+#include "PhraseMatcher.hpp"
+#include "MessageSource.hpp"
+#include "RunStats.hpp"
+
+#ifndef EX3_BATCHRUNNER_HPP
+#define EX3_BATCHRUNNER_HPP
+
+#define SPAM_VERDICT "SPAM"
+#define NOT_SPAM_VERDICT "NOT_SPAM"
+#define UNREADABLE_VERDICT "Invalid input"
+#define VERDICT_SEPARATOR '\t'
+
+/**
+ * @brief the settings of a batch run
+ */
+struct BatchOptions
+{
+    //the score at which a message is spam
+    int threshold;
+    size_t threadCount;
+    //score messages to the end and write the score, instead of stopping at the threshold
+    bool fullScore;
+    //messages of at least this many bytes are split between the threads
+    size_t parallelCutoff;
+};
+
+/**
+ * @brief scores the messages of a batch on a pool of worker threads and writes a line for every
+ * message, in input order: its path, the verdict separator and its verdict, followed by the
+ * separator and its score if the full score was asked for. a message that can't be read gets the
+ * unreadable verdict instead. messages in flight are kept in a window of a fixed number of
+ * messages per thread, so memory doesn't grow with the batch, and a large message is split
+ * between the workers that have nothing else to do
+ * @param matcher the compiled map from words (or sentence to score)
+ * @param messages the messages of the batch
+ * @param options the settings of the run
+ * @param out the stream to write the verdicts to
+ * @param stats the stats of the run
+ * @return true if every message was read, false otherwise
+ */
+bool scoreBatch(const PhraseMatcher &matcher, MessageSource &messages, const BatchOptions &options,
+                std::ostream &out, RunStats &stats);
+
+#endif //EX3_BATCHRUNNER_HPP
@@ -0,0 +1,97 @@
+#include "CaseFold.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CASE_FOLD_X86
+#endif
+
+const char UPPER_FIRST = 'A';
+const char UPPER_LAST = 'Z';
+const char CASE_BIT = 'a' - 'A';
+
+namespace
+{
+    typedef void (*FoldFunction)(const char *, char *, size_t);
+
+#ifdef CASE_FOLD_X86
+    const int SSE_WIDTH = 16;
+    const int AVX_WIDTH = 32;
+    //shifting 'A' to the lowest signed byte value makes "is upper case" a single signed compare
+    const char SIGNED_SHIFT = (char) (-128 - UPPER_FIRST);
+    const char SHIFTED_LIMIT = (char) (-128 + (UPPER_LAST - UPPER_FIRST + 1));
+
+    /**
+     * @brief the SSE2 version of foldAsciiLower, 16 bytes at a time
+     */
+    void foldAsciiLowerSse2(const char *source, char *destination, size_t size)
+    {
+        const __m128i shift = _mm_set1_epi8(SIGNED_SHIFT);
+        const __m128i limit = _mm_set1_epi8(SHIFTED_LIMIT);
+        const __m128i caseBit = _mm_set1_epi8(CASE_BIT);
+        size_t byteIdx = 0;
+        for (; byteIdx + SSE_WIDTH <= size; byteIdx += SSE_WIDTH)
+        {
+            __m128i bytes = _mm_loadu_si128((const __m128i *) (source + byteIdx));
+            __m128i isUpper = _mm_cmplt_epi8(_mm_add_epi8(bytes, shift), limit);
+            bytes = _mm_or_si128(bytes, _mm_and_si128(isUpper, caseBit));
+            _mm_storeu_si128((__m128i *) (destination + byteIdx), bytes);
+        }
+        foldAsciiLowerScalar(source + byteIdx, destination + byteIdx, size - byteIdx);
+    }
+
+    /**
+     * @brief the AVX2 version of foldAsciiLower, 32 bytes at a time
+     */
+    __attribute__((target("avx2")))
+    void foldAsciiLowerAvx2(const char *source, char *destination, size_t size)
+    {
+        const __m256i shift = _mm256_set1_epi8(SIGNED_SHIFT);
+        const __m256i limit = _mm256_set1_epi8(SHIFTED_LIMIT);
+        const __m256i caseBit = _mm256_set1_epi8(CASE_BIT);
+        size_t byteIdx = 0;
+        for (; byteIdx + AVX_WIDTH <= size; byteIdx += AVX_WIDTH)
+        {
+            __m256i bytes = _mm256_loadu_si256((const __m256i *) (source + byteIdx));
+            __m256i isUpper = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(bytes, shift));
+            bytes = _mm256_or_si256(bytes, _mm256_and_si256(isUpper, caseBit));
+            _mm256_storeu_si256((__m256i *) (destination + byteIdx), bytes);
+        }
+        foldAsciiLowerSse2(source + byteIdx, destination + byteIdx, size - byteIdx);
+    }
+#endif
+
+    /**
+     * @brief picks the widest version the cpu supports
+     * @return the version to use
+     */
+    FoldFunction chooseFoldFunction()
+    {
+#ifdef CASE_FOLD_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return foldAsciiLowerAvx2;
+        }
+        if (__builtin_cpu_supports("sse2"))
+        {
+            return foldAsciiLowerSse2;
+        }
+#endif
+        return foldAsciiLowerScalar;
+    }
+}
+
+void foldAsciiLowerScalar(const char *source, char *destination, size_t size)
+{
+    for (size_t byteIdx = 0; byteIdx < size; byteIdx++)
+    {
+        char byte = source[byteIdx];
+        destination[byteIdx] = (byte >= UPPER_FIRST && byte <= UPPER_LAST) ? byte | CASE_BIT : byte;
+    }
+}
+
+void foldAsciiLower(const char *source, char *destination, size_t size)
+{
+    static const FoldFunction foldFunction = chooseFoldFunction();
+    foldFunction(source, destination, size);
+}
@@ -0,0 +1,24 @@
+#include <cstddef>
+
+#ifndef EX3_CASEFOLD_HPP
+#define EX3_CASEFOLD_HPP
+
+/**
+ * @brief lower cases the ASCII letters of a buffer, leaving every other byte as is. this is
+ * exactly what std::tolower does in the "C" locale the detector runs in. uses AVX2 or SSE2 when
+ * the cpu has them, picked once at runtime, and a plain loop otherwise
+ * @param source the bytes to fold
+ * @param destination where to write the folded bytes, may be the source itself
+ * @param size the number of bytes
+ */
+void foldAsciiLower(const char *source, char *destination, size_t size);
+
+/**
+ * @brief the plain loop version of foldAsciiLower, one byte at a time
+ * @param source the bytes to fold
+ * @param destination where to write the folded bytes, may be the source itself
+ * @param size the number of bytes
+ */
+void foldAsciiLowerScalar(const char *source, char *destination, size_t size);
+
+#endif //EX3_CASEFOLD_HPP
@@ -0,0 +1,484 @@
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <tuple>
+#include <cstdint>
+#include "HashMap.hpp"
+
+#ifndef EX3_CONCURRENTHASHMAP_HPP
+#define EX3_CONCURRENTHASHMAP_HPP
+
+const size_t DEFAULT_SHARD_COUNT = 64;
+const size_t SHARD_START_CAPACITY = 16;
+//tables are kept at most half full, so a probe for a missing key ends quickly
+const size_t SHARD_LOAD_DIVISOR = 2;
+//the shard of a key is taken from bits of its hash far above the ones that pick its slot
+const int SHARD_HASH_SHIFT = 40;
+const size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * @brief This class represents a hash map that may be used from any number of threads at once.
+ * keys are split over shards by their hash, and every shard has a lock that only writers take,
+ * so writers to different shards never wait for each other. readers never lock or wait: a shard is
+ * an open addressed table of atomic slots, and a pair is published to it in a single store once
+ * it's complete and never moves after, so a reader sees a pair either whole or not at all.
+ * to keep that true:
+ * - pairs are never erased, only added
+ * - a table replaced by a larger one is kept until the map is destroyed, since a reader may still
+ * be probing it. it's at most as large as the table that replaced it, and reserving up front
+ * avoids it altogether
+ * - the map only synchronizes adding pairs. a value changed after its pair is added, such as a
+ * hit counter, should be an atomic
+ * @tparam KeyT the key of a pair in the map
+ * @tparam ValueT the value of the said pair
+ * @tparam HashT the hash of the keys, the same as in HashMap
+ */
+template <typename KeyT, typename ValueT, typename HashT = HashMapHash<KeyT>>
+class ConcurrentHashMap
+{
+private:
+    typedef std::pair<const KeyT, ValueT> pair_type;
+
+    /**
+     * @brief a slot of a table. the hash is stored before the pair is published, so a reader
+     * that sees the pair sees its hash too
+     */
+    struct Slot
+    {
+        std::atomic<size_t> hash;
+        std::atomic<pair_type *> pair;
+    };
+
+    /**
+     * @brief an open addressed table of a shard, probed linearly
+     */
+    struct Table
+    {
+        explicit Table(size_t capacity) : capacity(capacity), slots(new Slot[capacity]())
+        {
+        }
+
+        size_t capacity;
+        std::unique_ptr<Slot[]> slots;
+    };
+
+    /**
+     * @brief a part of the map, on a cache line of its own so writers to different shards don't
+     * slow each other down
+     */
+    struct alignas(CACHE_LINE_SIZE) Shard
+    {
+        std::mutex lock;
+        std::atomic<Table *> table{nullptr};
+        std::atomic<size_t> size{0};
+        //every table the shard had, the current one last
+        std::vector<std::unique_ptr<Table>> tables;
+        //the pairs of the shard. a deque never moves its elements as it grows
+        std::deque<pair_type> pairs;
+    };
+
+    size_t _shardCount;
+    std::unique_ptr<Shard[]> _shards;
+
+    /**
+     * @param key the key to hash
+     * @return the full hash of the key
+     */
+    template <typename LookupT>
+    static size_t _hash(const LookupT &key)
+    {
+        return HashT{} (key);
+    }
+
+    /**
+     * @param hash the full hash of a key
+     * @return the shard of the key
+     */
+    Shard &_shardOf(size_t hash) const
+    {
+        return _shards[(hash >> SHARD_HASH_SHIFT) & (_shardCount - 1)];
+    }
+
+    /**
+     * @brief finds a key in a table. wait free, a probe reads at most every slot once and the
+     * table is never full
+     * @param table the table to probe
+     * @param key the key to look for
+     * @param hash the hash of the key
+     * @return the pair of the key, or null if it's not in the table
+     */
+    template <typename LookupT>
+    static pair_type *_findIn(const Table &table, const LookupT &key, size_t hash)
+    {
+        size_t slotIdx = hash & (table.capacity - 1);
+        while (true)
+        {
+            pair_type *pair = table.slots[slotIdx].pair.load(std::memory_order_acquire);
+            if (pair == nullptr)
+            {
+                return nullptr;
+            }
+            //keys of another hash are told apart without reading the pair
+            if (table.slots[slotIdx].hash.load(std::memory_order_relaxed) == hash &&
+                pair->first == key)
+            {
+                return pair;
+            }
+            slotIdx = (slotIdx + 1) & (table.capacity - 1);
+        }
+    }
+
+    /**
+     * @param key the key to look for
+     * @param hash the hash of the key
+     * @return the pair of the key, or null if it's not in the map
+     */
+    template <typename LookupT>
+    pair_type *_find(const LookupT &key, size_t hash) const
+    {
+        return _findIn(*_shardOf(hash).table.load(std::memory_order_acquire), key, hash);
+    }
+
+    /**
+     * @brief publishes a pair in a free slot of a table. the shard lock must be held
+     * @param table the table to publish in
+     * @param pair the pair
+     * @param hash the hash of the key of the pair
+     */
+    static void _place(Table &table, pair_type *pair, size_t hash)
+    {
+        size_t slotIdx = hash & (table.capacity - 1);
+        while (table.slots[slotIdx].pair.load(std::memory_order_relaxed) != nullptr)
+        {
+            slotIdx = (slotIdx + 1) & (table.capacity - 1);
+        }
+        table.slots[slotIdx].hash.store(hash, std::memory_order_relaxed);
+        table.slots[slotIdx].pair.store(pair, std::memory_order_release);
+    }
+
+    /**
+     * @brief makes sure a shard has room for more pairs, replacing its table with a larger one
+     * if needed. the pairs are placed by their stored hash, and readers move on to the new table
+     * once it's complete. the shard lock must be held
+     * @param shard the shard
+     * @param pairCount the number of pairs to make room for
+     * @return the table of the shard
+     */
+    static Table &_makeRoom(Shard &shard, size_t pairCount)
+    {
+        Table *table = shard.table.load(std::memory_order_relaxed);
+        size_t capacity = table->capacity;
+        while (pairCount > capacity / SHARD_LOAD_DIVISOR)
+        {
+            capacity *= RESIZE_FACTOR;
+        }
+        if (capacity == table->capacity)
+        {
+            return *table;
+        }
+        shard.tables.emplace_back(new Table(capacity));
+        Table *grown = shard.tables.back().get();
+        for (size_t slotIdx = 0; slotIdx < table->capacity; slotIdx++)
+        {
+            pair_type *pair = table->slots[slotIdx].pair.load(std::memory_order_relaxed);
+            if (pair != nullptr)
+            {
+                _place(*grown, pair, table->slots[slotIdx].hash.load(std::memory_order_relaxed));
+            }
+        }
+        shard.table.store(grown, std::memory_order_release);
+        return *grown;
+    }
+
+    /**
+     * @brief adds a pair constructed in place, unless its key is already in the map
+     * @param key the key of the pair
+     * @param args the arguments to construct the value from
+     * @return the value of the key, and true if the pair was added
+     */
+    template <typename KeyArgT, typename... Args>
+    std::pair<ValueT *, bool> _tryEmplace(KeyArgT &&key, Args &&... args)
+    {
+        size_t hash = _hash(key);
+        Shard &shard = _shardOf(hash);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        pair_type *found = _findIn(*shard.table.load(std::memory_order_relaxed), key, hash);
+        if (found != nullptr)
+        {
+            return std::make_pair(&found->second, false);
+        }
+        //room is made first, so a failed allocation leaves nothing behind
+        size_t size = shard.size.load(std::memory_order_relaxed) + 1;
+        Table &table = _makeRoom(shard, size);
+        shard.pairs.emplace_back(std::piecewise_construct,
+                                 std::forward_as_tuple(std::forward<KeyArgT>(key)),
+                                 std::forward_as_tuple(std::forward<Args>(args)...));
+        _place(table, &shard.pairs.back(), hash);
+        shard.size.store(size, std::memory_order_relaxed);
+        return std::make_pair(&shard.pairs.back().second, true);
+    }
+
+public:
+    /**
+     * @brief constructor for this class
+     * @param shardCount the number of shards, rounded up to a power of two. more shards let more
+     * writers run at once
+     */
+    explicit ConcurrentHashMap(size_t shardCount = DEFAULT_SHARD_COUNT) : _shardCount(1)
+    {
+        while (_shardCount < shardCount)
+        {
+            _shardCount *= RESIZE_FACTOR;
+        }
+        _shards.reset(new Shard[_shardCount]);
+        for (size_t shardIdx = 0; shardIdx < _shardCount; shardIdx++)
+        {
+            _shards[shardIdx].tables.emplace_back(new Table(SHARD_START_CAPACITY));
+            _shards[shardIdx].table.store(_shards[shardIdx].tables.back().get(),
+                                          std::memory_order_relaxed);
+        }
+    }
+
+    ConcurrentHashMap(const ConcurrentHashMap &other) = delete;
+
+    ConcurrentHashMap &operator=(const ConcurrentHashMap &other) = delete;
+
+    /**
+     * @return number of elements in this table. while pairs are being added it's only a
+     * snapshot, and may miss some that are in
+     */
+    size_t size() const
+    {
+        size_t size = 0;
+        for (size_t shardIdx = 0; shardIdx < _shardCount; shardIdx++)
+        {
+            size += _shards[shardIdx].size.load(std::memory_order_relaxed);
+        }
+        return size;
+    }
+
+    /**
+     * @return true if table is empty, false otherwise
+     */
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /**
+     * @return the number of shards
+     */
+    size_t shardCount() const
+    {
+        return _shardCount;
+    }
+
+    /**
+     * @brief grows every shard once so that the map can hold a number of pairs spread evenly
+     * over the shards without replacing a table
+     * @param pairCount the number of pairs to make room for
+     */
+    void reserve(size_t pairCount)
+    {
+        size_t shardPairs = (pairCount + _shardCount - 1) / _shardCount;
+        for (size_t shardIdx = 0; shardIdx < _shardCount; shardIdx++)
+        {
+            std::lock_guard<std::mutex> guard(_shards[shardIdx].lock);
+            _makeRoom(_shards[shardIdx], shardPairs);
+        }
+    }
+
+    /**
+     * @brief method to isnert a pair into this class
+     * @param key the key of the pair
+     * @param value the value of the pair
+     * @return true if the pair was added, false if the key was already in the map
+     */
+    bool insert(const KeyT &key, const ValueT &value)
+    {
+        return _tryEmplace(key, value).second;
+    }
+
+    /**
+     * @brief inserts a key with a value constructed in place, unless the key is already in the
+     * map, in which case nothing is constructed
+     * @param key the key of the pair
+     * @param args the arguments to construct the value from
+     * @return the value of the key, which stays at the same address for as long as the map
+     * exists, and true if the pair was inserted
+     */
+    template <typename... Args>
+    std::pair<ValueT *, bool> try_emplace(const KeyT &key, Args &&... args)
+    {
+        return _tryEmplace(key, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief inserts a key with a value constructed in place, unless the key is already in the
+     * map, in which case nothing is constructed or moved
+     * @param key the key of the pair, moved in only if it's inserted
+     * @param args the arguments to construct the value from
+     * @return the value of the key, which stays at the same address for as long as the map
+     * exists, and true if the pair was inserted
+     */
+    template <typename... Args>
+    std::pair<ValueT *, bool> try_emplace(KeyT &&key, Args &&... args)
+    {
+        return _tryEmplace(std::move(key), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief adds a range of pairs, taking the lock of every shard once instead of once per pair.
+     * a key already in the map has its value combined with the value of the range, under the lock
+     * of its shard. threads merging ranges at the same time start at different shards, so they
+     * mostly take different locks. the range is read twice, once to bucket it and once to add it,
+     * so it must be a forward range
+     * @param first the first pair of the range
+     * @param last the end of the range
+     * @param combine called with the value in the map and the value of the range for every key
+     * that is already in the map
+     */
+    template <typename ForwardIt, typename CombineT>
+    void merge(ForwardIt first, ForwardIt last, CombineT combine)
+    {
+        static_assert(std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<
+                              ForwardIt>::iterator_category>::value,
+                      "merge reads its range twice, so it needs forward iterators");
+        //the pairs are bucketed by shard, keeping the hash that picked it
+        std::vector<std::pair<size_t, ForwardIt>> batch;
+        std::vector<size_t> shardStarts(_shardCount + 1, 0);
+        for (; first != last; ++first)
+        {
+            size_t hash = _hash(first->first);
+            batch.emplace_back(hash, first);
+            shardStarts[((hash >> SHARD_HASH_SHIFT) & (_shardCount - 1)) + 1]++;
+        }
+        for (size_t shardIdx = 0; shardIdx < _shardCount; shardIdx++)
+        {
+            shardStarts[shardIdx + 1] += shardStarts[shardIdx];
+        }
+        std::vector<std::pair<size_t, ForwardIt>> ordered(batch);
+        std::vector<size_t> shardEnds(shardStarts.begin(), shardStarts.end() - 1);
+        for (const auto &entry : batch)
+        {
+            ordered[shardEnds[(entry.first >> SHARD_HASH_SHIFT) & (_shardCount - 1)]++] = entry;
+        }
+        size_t startShard = foldMultiply(std::hash<std::thread::id>{}(std::this_thread::get_id()),
+                                         HASH_MULTIPLIER) & (_shardCount - 1);
+        for (size_t shardStep = 0; shardStep < _shardCount; shardStep++)
+        {
+            size_t shardIdx = (startShard + shardStep) & (_shardCount - 1);
+            if (shardStarts[shardIdx] == shardStarts[shardIdx + 1])
+            {
+                continue;
+            }
+            Shard &shard = _shards[shardIdx];
+            std::lock_guard<std::mutex> guard(shard.lock);
+            size_t size = shard.size.load(std::memory_order_relaxed);
+            for (size_t entryIdx = shardStarts[shardIdx]; entryIdx < shardStarts[shardIdx + 1];
+                 entryIdx++)
+            {
+                size_t hash = ordered[entryIdx].first;
+                const auto &source = *ordered[entryIdx].second;
+                Table &table = _makeRoom(shard, size + 1);
+                pair_type *found = _findIn(table, source.first, hash);
+                if (found != nullptr)
+                {
+                    combine(found->second, source.second);
+                    continue;
+                }
+                shard.pairs.emplace_back(source.first, source.second);
+                _place(table, &shard.pairs.back(), hash);
+                shard.size.store(++size, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief adds the pairs of another map, see merge of a range
+     * @param other the map to add, a HashMap for example
+     * @param combine called with the value in this map and the value in the other map for every
+     * key that is in both
+     */
+    template <typename MapT, typename CombineT>
+    void merge(const MapT &other, CombineT combine)
+    {
+        merge(other.begin(), other.end(), combine);
+    }
+
+    /**
+     * @brief method to check if a key is contained in the table. never waits
+     * @param key the key to check if it's contained
+     * @return true if it's contained, false otherwise
+     */
+    bool containsKey(const KeyT &key) const
+    {
+        return _find(key, _hash(key)) != nullptr;
+    }
+
+    /**
+     * @brief method to check if a string key is contained in the table, without building a string
+     * @param key the string view or c string to check if it's contained
+     * @return true if it's contained, false otherwise
+     */
+    template <typename LookupT, EnableTransparentLookup<KeyT, LookupT> = 0>
+    bool containsKey(const LookupT &key) const
+    {
+        return _find(key, _hash(key)) != nullptr;
+    }
+
+    /**
+     * @brief finds the value of a key. never waits
+     * @param key the key to look for
+     * @return the value of the key, or null if it's not in the map
+     */
+    ValueT *find(const KeyT &key) const
+    {
+        pair_type *pair = _find(key, _hash(key));
+        return pair == nullptr ? nullptr : &pair->second;
+    }
+
+    /**
+     * @brief finds the value of a string key, without building a string. never waits
+     * @param key the string view or c string to look for
+     * @return the value of the key, or null if it's not in the map
+     */
+    template <typename LookupT, EnableTransparentLookup<KeyT, LookupT> = 0>
+    ValueT *find(const LookupT &key) const
+    {
+        pair_type *pair = _find(key, _hash(key));
+        return pair == nullptr ? nullptr : &pair->second;
+    }
+
+    /**
+     * @brief visits every pair in the map. pairs added while visiting may or may not be visited
+     * @param visit called with the key and value of every pair
+     */
+    template <typename VisitT>
+    void forEach(VisitT visit) const
+    {
+        for (size_t shardIdx = 0; shardIdx < _shardCount; shardIdx++)
+        {
+            const Table &table = *_shards[shardIdx].table.load(std::memory_order_acquire);
+            for (size_t slotIdx = 0; slotIdx < table.capacity; slotIdx++)
+            {
+                pair_type *pair = table.slots[slotIdx].pair.load(std::memory_order_acquire);
+                if (pair != nullptr)
+                {
+                    visit(pair->first, pair->second);
+                }
+            }
+        }
+    }
+};
+
+#endif //EX3_CONCURRENTHASHMAP_HPP
@@ -0,0 +1,201 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include "ConcurrentHashMap.hpp"
+#include "TestCheck.hpp"
+
+const size_t TEST_THREADS = 8;
+const size_t TEST_KEYS = 20000;
+//few shards with small tables, so shards grow while they are being read
+const size_t TEST_SHARDS = 4;
+const size_t HOT_KEYS = 100;
+
+/**
+ * @brief runs work on a number of threads at once and waits for all of them
+ * @param work called on every thread with its index
+ */
+void runThreads(const std::function<void(size_t)> &work)
+{
+    std::vector<std::thread> threads;
+    for (size_t threadIdx = 0; threadIdx < TEST_THREADS; threadIdx++)
+    {
+        threads.emplace_back(work, threadIdx);
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+/**
+ * @return the keys of the tests
+ */
+std::vector<std::string> makeKeys()
+{
+    std::vector<std::string> keys;
+    for (size_t keyIdx = 0; keyIdx < TEST_KEYS; keyIdx++)
+    {
+        keys.push_back("key" + std::to_string(keyIdx));
+    }
+    return keys;
+}
+
+/**
+ * @brief threads insert the same keys at once while finding them, so every key is added by
+ * exactly one thread, and a key that is found is found whole
+ */
+void testConcurrentInsertAndFind(const std::vector<std::string> &keys)
+{
+    ConcurrentHashMap<std::string, int> map(TEST_SHARDS);
+    std::atomic<size_t> inserted(0);
+    std::atomic<bool> torn(false);
+    runThreads([&](size_t threadIdx)
+    {
+        for (size_t step = 0; step < keys.size(); step++)
+        {
+            //every thread goes over all the keys, from a different start
+            size_t keyIdx = (step + threadIdx * keys.size() / TEST_THREADS) % keys.size();
+            if (map.insert(keys[keyIdx], (int) keyIdx))
+            {
+                inserted++;
+            }
+            const int *value = map.find(keys[(keyIdx * 7) % keys.size()]);
+            if (value != nullptr && *value != (int) ((keyIdx * 7) % keys.size()))
+            {
+                torn = true;
+            }
+        }
+    });
+    check(inserted == keys.size() && map.size() == keys.size(),
+          "every key is inserted by exactly one thread");
+    check(!torn, "a pair found while inserting is whole");
+    bool found = true;
+    for (size_t keyIdx = 0; keyIdx < keys.size(); keyIdx++)
+    {
+        const int *value = map.find(keys[keyIdx]);
+        found = found && value != nullptr && *value == (int) keyIdx;
+    }
+    check(found, "every key is found after inserting");
+    check(map.containsKey(std::string_view(keys[1])) && map.find(keys[2].c_str()) != nullptr &&
+          !map.containsKey("missing"), "lookups by string view and c string");
+}
+
+/**
+ * @brief threads count hits of a few keys in atomic values, and try_emplace keeps values at the
+ * same address
+ */
+void testConcurrentCounters(const std::vector<std::string> &keys)
+{
+    ConcurrentHashMap<std::string_view, std::atomic<long>> hits(TEST_SHARDS);
+    std::vector<std::atomic<long> *> addresses;
+    for (size_t keyIdx = 0; keyIdx < HOT_KEYS; keyIdx++)
+    {
+        addresses.push_back(hits.try_emplace(keys[keyIdx], 0).first);
+    }
+    runThreads([&](size_t threadIdx)
+    {
+        for (size_t step = 0; step < keys.size(); step++)
+        {
+            hits.find(keys[(step + threadIdx) % HOT_KEYS])->fetch_add(1,
+                                                                      std::memory_order_relaxed);
+            //new keys grow the shards under the counters
+            hits.try_emplace(keys[HOT_KEYS + (step * TEST_THREADS + threadIdx) %
+                                             (keys.size() - HOT_KEYS)], 0);
+        }
+    });
+    long total = 0;
+    bool stable = true;
+    for (size_t keyIdx = 0; keyIdx < HOT_KEYS; keyIdx++)
+    {
+        stable = stable && hits.find(keys[keyIdx]) == addresses[keyIdx];
+        total += addresses[keyIdx]->load();
+    }
+    check(stable, "values keep their address as the map grows");
+    check(total == (long) (keys.size() * TEST_THREADS), "every hit is counted");
+    size_t visited = 0;
+    hits.forEach([&](std::string_view, const std::atomic<long> &)
+                 {
+                     visited++;
+                 });
+    check(visited == keys.size() && hits.size() == keys.size(), "forEach visits every pair");
+}
+
+/**
+ * @brief threads merge maps of overlapping keys at once, combining the values of shared keys
+ */
+void testConcurrentMerge(const std::vector<std::string> &keys)
+{
+    ConcurrentHashMap<std::string, int> map(TEST_SHARDS);
+    std::vector<HashMap<std::string, int>> threadMaps(TEST_THREADS);
+    for (size_t threadIdx = 0; threadIdx < TEST_THREADS; threadIdx++)
+    {
+        //every key is shared by all the threads, and every thread has a key of its own
+        for (const auto &key : keys)
+        {
+            threadMaps[threadIdx].insert(key, 1);
+        }
+        threadMaps[threadIdx].insert("own" + std::to_string(threadIdx), (int) threadIdx);
+    }
+    runThreads([&](size_t threadIdx)
+    {
+        map.merge(threadMaps[threadIdx], [](int &value, int other)
+        {
+            value += other;
+        });
+    });
+    check(map.size() == keys.size() + TEST_THREADS, "merged maps hold every key once");
+    bool combined = true;
+    for (const auto &key : keys)
+    {
+        combined = combined && *map.find(key) == (int) TEST_THREADS;
+    }
+    check(combined, "shared keys are combined once per merged map");
+    bool own = true;
+    for (size_t threadIdx = 0; threadIdx < TEST_THREADS; threadIdx++)
+    {
+        const int *value = map.find("own" + std::to_string(threadIdx));
+        own = own && value != nullptr && *value == (int) threadIdx;
+    }
+    check(own, "keys of a single map keep their value");
+}
+
+/**
+ * @brief reserving, a single shard, and shard counts that aren't a power of two
+ */
+void testShards()
+{
+    ConcurrentHashMap<int, int> single(1);
+    for (int key = 0; key < 1000; key++)
+    {
+        single.insert(key, key);
+    }
+    check(single.shardCount() == 1 && single.size() == 1000 && *single.find(999) == 999 &&
+          !single.containsKey(1000), "a single shard");
+    ConcurrentHashMap<int, int> rounded(5);
+    check(rounded.shardCount() == 8 && rounded.empty(), "shard counts round up to a power of two");
+    rounded.reserve(10000);
+    for (int key = 0; key < 10000; key++)
+    {
+        rounded.insert(key, -key);
+    }
+    check(rounded.size() == 10000 && *rounded.find(1234) == -1234, "inserting after reserve");
+    check(!rounded.insert(1, 1) && *rounded.find(1) == -1, "insert keeps an existing value");
+}
+
+/**
+ * @brief runs the tests of ConcurrentHashMap. they are also built with the thread sanitizer,
+ * which checks the map's claims about what may run at once
+ * @return 0 if all checks passed, exit failure constant otherwise
+ */
+int main()
+{
+    std::vector<std::string> keys = makeKeys();
+    testConcurrentInsertAndFind(keys);
+    testConcurrentCounters(keys);
+    testConcurrentMerge(keys);
+    testShards();
+    return checkResult();
+}
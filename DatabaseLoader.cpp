@@ -0,0 +1,173 @@
+#include <fstream>
+#include <algorithm>
+#include <sstream>
+#include <cstring>
+#include <climits>
+#include <thread>
+#include <memory>
+#include <stdexcept>
+#include <exception>
+#include "DatabaseLoader.hpp"
+#include "MappedFile.hpp"
+#include "CaseFold.hpp"
+
+const char LINE_END = '\n';
+const char FIELD_SEPARATOR = ',';
+const int DECIMAL_BASE = 10;
+//smaller chunks aren't worth a thread
+const size_t MIN_PARALLEL_CHUNK_SIZE = 4 * 1024 * 1024;
+//a rough guess of the line length, only used to reserve the vectors
+const size_t ESTIMATED_LINE_SIZE = 16;
+
+namespace
+{
+    /**
+     * @brief the records parsed from one chunk of the database
+     */
+    struct ParsedChunk
+    {
+        std::vector<std::string_view> words;
+        std::vector<int> scores;
+        std::exception_ptr error;
+    };
+
+    /**
+     * @brief parses whole lines of the database
+     * @param first the first byte of the first line
+     * @param last the end of the last line
+     * @param phraseBytes where to write the lower cased phrases, with room for last - first bytes
+     * @param chunk the chunk to store the records in
+     */
+    void parseLines(const char *first, const char *last, char *phraseBytes, ParsedChunk &chunk)
+    {
+        chunk.words.reserve((last - first) / ESTIMATED_LINE_SIZE);
+        chunk.scores.reserve((last - first) / ESTIMATED_LINE_SIZE);
+        while (first < last)
+        {
+            const char *lineEnd = static_cast<const char *>(std::memchr(first, LINE_END,
+                                                                        last - first));
+            if (lineEnd == nullptr)
+            {
+                lineEnd = last;
+            }
+            const char *separator = static_cast<const char *>(
+                    std::memchr(first, FIELD_SEPARATOR, lineEnd - first));
+            //the score must be there, and a second comma fails the digit check below
+            if (separator == nullptr || separator + 1 == lineEnd)
+            {
+                throw std::invalid_argument(INVALID_DATABASE_ERROR);
+            }
+            long score = 0;
+            for (const char *digit = separator + 1; digit < lineEnd; digit++)
+            {
+                if (*digit < '0' || *digit > '9')
+                {
+                    throw std::invalid_argument(INVALID_DATABASE_ERROR);
+                }
+                score = score * DECIMAL_BASE + (*digit - '0');
+                if (score > INT_MAX)
+                {
+                    throw std::invalid_argument(INVALID_DATABASE_ERROR);
+                }
+            }
+            foldAsciiLower(first, phraseBytes, separator - first);
+            chunk.words.emplace_back(phraseBytes, separator - first);
+            phraseBytes += separator - first;
+            chunk.scores.push_back((int) score);
+            first = lineEnd + 1;
+        }
+    }
+}
+
+void parseDatabaseBuffer(std::string_view buffer, std::vector<std::string_view> &words,
+                         std::vector<int> &scores, StringPool &pool, size_t threadCount)
+{
+    size_t chunkCount = std::max<size_t>(1, std::min(threadCount,
+                                                     buffer.size() / MIN_PARALLEL_CHUNK_SIZE));
+    //chunk boundaries are moved forward to just after a line end
+    std::vector<const char *> boundaries(1, buffer.data());
+    const char *bufferEnd = buffer.data() + buffer.size();
+    for (size_t chunkIdx = 1; chunkIdx < chunkCount; chunkIdx++)
+    {
+        const char *boundary = std::max(boundaries.back(),
+                                        buffer.data() + buffer.size() * chunkIdx / chunkCount);
+        const char *lineEnd = static_cast<const char *>(std::memchr(boundary, LINE_END,
+                                                                    bufferEnd - boundary));
+        boundaries.push_back(lineEnd == nullptr ? bufferEnd : lineEnd + 1);
+    }
+    boundaries.push_back(bufferEnd);
+
+    //a phrase is shorter than its line, so every chunk writes its phrases into the part of a
+    //single buffer that lines up with its own lines, and the chunks never overlap
+    char *phraseBytes = pool.allocate(buffer.size());
+    std::vector<ParsedChunk> chunks(chunkCount);
+    std::vector<std::thread> workers;
+    for (size_t chunkIdx = 0; chunkIdx < chunkCount; chunkIdx++)
+    {
+        auto parseChunk = [&boundaries, &chunks, &buffer, phraseBytes, chunkIdx]
+        {
+            try
+            {
+                parseLines(boundaries[chunkIdx], boundaries[chunkIdx + 1],
+                           phraseBytes + (boundaries[chunkIdx] - buffer.data()), chunks[chunkIdx]);
+            }
+            catch (...)
+            {
+                chunks[chunkIdx].error = std::current_exception();
+            }
+        };
+        if (chunkIdx + 1 == chunkCount)
+        {
+            parseChunk(); //the last chunk is parsed on the calling thread
+        }
+        else
+        {
+            workers.emplace_back(parseChunk);
+        }
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    size_t recordCount = 0;
+    for (const auto &chunk : chunks)
+    {
+        if (chunk.error)
+        {
+            std::rethrow_exception(chunk.error);
+        }
+        recordCount += chunk.words.size();
+    }
+    words.reserve(words.size() + recordCount);
+    scores.reserve(scores.size() + recordCount);
+    for (auto &chunk : chunks)
+    {
+        words.insert(words.end(), chunk.words.begin(), chunk.words.end());
+        scores.insert(scores.end(), chunk.scores.begin(), chunk.scores.end());
+    }
+}
+
+void readFileIntoVectors(std::vector<std::string_view> &words, std::vector<int> &scores,
+                         StringPool &pool, std::string filePath, size_t threadCount)
+{
+    std::unique_ptr<MappedFile> mapping;
+    try
+    {
+        mapping.reset(new MappedFile(filePath));
+    }
+    catch (const std::invalid_argument &) //not a regular file, or can't be mapped
+    {
+    }
+    if (mapping == nullptr || mapping->size() == 0) //some special files report no size
+    {
+        std::ifstream fileReader(filePath);
+        std::stringstream contents;
+        contents << fileReader.rdbuf();
+        parseDatabaseBuffer(contents.str(), words, scores, pool, threadCount);
+        return;
+    }
+    mapping->adviseSequential();
+    parseDatabaseBuffer(std::string_view(mapping->data(), mapping->size()), words, scores, pool,
+                        threadCount);
+}
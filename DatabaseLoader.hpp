@@ -0,0 +1,41 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include "StringPool.hpp"
+
+#ifndef EX3_DATABASELOADER_HPP
+#define EX3_DATABASELOADER_HPP
+
+#define INVALID_DATABASE_ERROR "Invalid input"
+
+/**
+ * @brief parses a buffer of "<phrase>,<score>" lines. every line must have exactly one comma
+ * followed by a non negative number that fits in an int, and phrases are lower cased. each line is
+ * validated and parsed in a single pass, in place. large buffers are split into chunks at line
+ * ends and parsed on several threads, keeping the order of the lines. the lower cased phrases are
+ * written into a single buffer of the pool, instead of a string each
+ * @param buffer the contents of the database
+ * @param words the vector to store the words in, views into the pool
+ * @param scores the vector to store scores in
+ * @param pool the pool that holds the words
+ * @param threadCount the most threads to parse with
+ * @throw std::invalid_argument if any line is malformed
+ */
+void parseDatabaseBuffer(std::string_view buffer, std::vector<std::string_view> &words,
+                         std::vector<int> &scores, StringPool &pool, size_t threadCount = 1);
+
+/**
+ * @brief creates vectors from a file of key value pairs. the file is mapped and parsed in place,
+ * files that can't be mapped are read into memory first
+ * @param words the vector to store the words in, views into the pool
+ * @param scores the vector to store scores in
+ * @param pool the pool that holds the words
+ * @param filePath the file to read from
+ * @param threadCount the most threads to parse with
+ * @throw std::invalid_argument if any line is malformed
+ */
+void readFileIntoVectors(std::vector<std::string_view> &words, std::vector<int> &scores,
+                         StringPool &pool, std::string filePath, size_t threadCount = 1);
+
+#endif //EX3_DATABASELOADER_HPP
@@ -0,0 +1,40 @@
+#include <iostream>
+#include <cstdlib>
+#include "DictionaryFile.hpp"
+#include "RunStats.hpp"
+#include "Scorer.hpp"
+
+#define BAKE_USAGE_MSG "Usage: dict_bake <database path> <header path>"
+#define GENERAL_ERROR "Invalid input"
+
+const int BAKE_ARG_NUMBER = 3;
+const int BAKE_DB_IDX = 1;
+const int BAKE_HEADER_IDX = 2;
+
+/**
+ * @brief compiles a database into a header of constexpr tables, which the detector is built
+ * with when configured with a baked dictionary. runs at build time
+ * @param argc the number of arguments
+ * @param argv the arguments
+ * @return 0 upon success completion, exit failure constant otherwise
+ */
+int main(int argc, char *argv[])
+{
+    if (argc != BAKE_ARG_NUMBER)
+    {
+        std::cerr << BAKE_USAGE_MSG << std::endl;
+        return EXIT_FAILURE;
+    }
+    try
+    {
+        RunStats stats(false);
+        writeDictionaryHeader(loadMatcher(argv[BAKE_DB_IDX], 1, true, stats),
+                              argv[BAKE_HEADER_IDX], argv[BAKE_DB_IDX]);
+    }
+    catch (...)
+    {
+        std::cerr << GENERAL_ERROR << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
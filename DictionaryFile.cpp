@@ -0,0 +1,458 @@
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <cstddef>
+#include <stdexcept>
+#include <memory>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include "DictionaryFile.hpp"
+#include "MappedFile.hpp"
+
+#define TEMP_FILE_SUFFIX ".tmp."
+
+const size_t MAGIC_SIZE = 8;
+const size_t SECTION_ALIGNMENT = 8;
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+const int BYTE_VALUES = 256;
+const size_t HEADER_VALUES_PER_LINE = 12;
+const mode_t DICTIONARY_FILE_MODE = 0666; //before the umask, like any new file
+
+namespace
+{
+    /**
+     * @brief the tables of the dictionary, in the order they are written
+     */
+    enum Section
+    {
+        EDGE_START, EDGE_LABEL, ROOT_NEXT, FAIL, TERMINAL_BITS, TERMINAL_RANK, OUTPUT_BITS,
+        OUTPUT_RANK, OUTPUT_LINK, PHRASE_LENGTH, PHRASE_SCORE, SECTION_COUNT
+    };
+
+    /**
+     * @brief position of a table in the file
+     */
+    struct SectionEntry
+    {
+        uint64_t offset;
+        uint64_t byteSize;
+    };
+
+    /**
+     * @brief the header at the start of every compiled dictionary
+     */
+    struct DictionaryHeader
+    {
+        char magic[MAGIC_SIZE];
+        uint32_t version;
+        uint32_t byteOrderMark;
+        uint64_t fileSize;
+        uint64_t stateCount;
+        uint64_t phraseCount;
+        uint64_t outputLinkCount;
+        SectionEntry sections[SECTION_COUNT];
+        uint64_t payloadChecksum;
+        uint64_t headerChecksum; //covers every field before it
+    };
+
+    /**
+     * @brief adds bytes to an FNV-1a checksum
+     * @param checksum the checksum so far
+     * @param data the bytes to add
+     * @param size the number of bytes
+     * @return the updated checksum
+     */
+    uint64_t fnv1a(uint64_t checksum, const char *data, size_t size)
+    {
+        for (size_t byteIdx = 0; byteIdx < size; byteIdx++)
+        {
+            checksum ^= (unsigned char) data[byteIdx];
+            checksum *= FNV_PRIME;
+        }
+        return checksum;
+    }
+
+    /**
+     * @brief the expected byte size of every table of a matcher
+     * @param tables the tables of the matcher
+     * @param sizes the array to store the sizes in
+     */
+    void sectionSizes(const PhraseMatcher::Tables &tables, uint64_t sizes[SECTION_COUNT])
+    {
+        size_t bitWords = PhraseMatcher::bitWordCount(tables.stateCount);
+        sizes[EDGE_START] = (tables.stateCount + 1) * sizeof(uint32_t);
+        sizes[EDGE_LABEL] = (tables.stateCount - 1) * sizeof(unsigned char);
+        sizes[ROOT_NEXT] = BYTE_VALUES * sizeof(uint32_t);
+        sizes[FAIL] = tables.stateCount * sizeof(uint32_t);
+        sizes[TERMINAL_BITS] = bitWords * sizeof(uint64_t);
+        sizes[TERMINAL_RANK] = bitWords * sizeof(uint32_t);
+        sizes[OUTPUT_BITS] = bitWords * sizeof(uint64_t);
+        sizes[OUTPUT_RANK] = bitWords * sizeof(uint32_t);
+        sizes[OUTPUT_LINK] = tables.outputLinkCount * sizeof(uint32_t);
+        sizes[PHRASE_LENGTH] = tables.phraseCount * sizeof(uint32_t);
+        sizes[PHRASE_SCORE] = tables.phraseCount * sizeof(int32_t);
+    }
+
+    /**
+     * @param word a word of bits
+     * @return the number of bits set in it
+     */
+    uint64_t setBits(uint64_t word)
+    {
+        return (uint64_t) __builtin_popcountll(word);
+    }
+
+    /**
+     * @param bits the bits
+     * @param index the index of a bit
+     * @return true if the bit is set, false otherwise
+     */
+    bool testBit(const uint64_t *bits, uint64_t index)
+    {
+        return (bits[index / BITS_IN_WORD] >> (index % BITS_IN_WORD)) & 1;
+    }
+
+    /**
+     * @param header the header of a file
+     * @return true if the header is a valid header of this version and byte order, false otherwise
+     */
+    bool headerValid(const DictionaryHeader &header)
+    {
+        return std::memcmp(header.magic, DICTIONARY_MAGIC, MAGIC_SIZE) == 0 &&
+               header.version == DICTIONARY_VERSION && header.byteOrderMark == BYTE_ORDER_MARK &&
+               header.headerChecksum == fnv1a(FNV_OFFSET_BASIS, (const char *) &header,
+                                              offsetof(DictionaryHeader, headerChecksum));
+    }
+
+    /**
+     * @brief checks every value the scanner follows or indexes with, so a corrupted dictionary
+     * is refused instead of reading outside the mapping, looping forever or counting a phrase
+     * from before the start of its line. the scanner keeps the depth of its state at most the
+     * number of bytes read since the line began, so links may only lead to shallower states and
+     * a phrase must be as long as the depth of its state. the layout of the tables must already
+     * be checked
+     * @param tables the tables of the dictionary
+     * @return true if every value is in range, false otherwise
+     */
+    bool tableValuesValid(const PhraseMatcher::Tables &tables)
+    {
+        uint64_t stateCount = tables.stateCount;
+        //edge e leads to state e + 1, so the edges of every state must be a range of edges
+        if (tables.edgeStart[0] != 0 || tables.edgeStart[stateCount] != stateCount - 1)
+        {
+            return false;
+        }
+        //the ranks must count the bits, so ranking a set bit always gives an index in range
+        uint64_t terminalRank = 0;
+        uint64_t outputRank = 0;
+        size_t bitWords = PhraseMatcher::bitWordCount(stateCount);
+        for (size_t wordIdx = 0; wordIdx < bitWords; wordIdx++)
+        {
+            if (tables.terminalRank[wordIdx] != terminalRank ||
+                tables.outputRank[wordIdx] != outputRank)
+            {
+                return false;
+            }
+            terminalRank += setBits(tables.terminalBits[wordIdx]);
+            outputRank += setBits(tables.outputBits[wordIdx]);
+        }
+        if (terminalRank != tables.phraseCount || outputRank != tables.outputLinkCount)
+        {
+            return false;
+        }
+        //edges lead to later states, so the depth of a state is known by the time it's checked
+        std::vector<uint32_t> depth(stateCount, 0);
+        uint64_t phraseIdx = 0;
+        uint64_t linkIdx = 0;
+        for (uint64_t state = 0; state < stateCount; state++)
+        {
+            uint64_t firstEdge = tables.edgeStart[state];
+            uint64_t endEdge = tables.edgeStart[state + 1];
+            if (firstEdge > endEdge || endEdge > stateCount - 1 ||
+                (firstEdge < endEdge && firstEdge < state))
+            {
+                return false;
+            }
+            for (uint64_t edge = firstEdge; edge < endEdge; edge++)
+            {
+                depth[edge + 1] = depth[state] + 1;
+            }
+            if (state != 0 && (tables.fail[state] >= state ||
+                               depth[tables.fail[state]] >= depth[state]))
+            {
+                return false;
+            }
+            if (testBit(tables.terminalBits, state) &&
+                tables.phraseLength[phraseIdx++] != depth[state])
+            {
+                return false;
+            }
+            //an output link must end a phrase, and lead to a shallower state so the chain ends
+            if (testBit(tables.outputBits, state))
+            {
+                uint32_t link = tables.outputLink[linkIdx++];
+                if (link >= state || !testBit(tables.terminalBits, link) ||
+                    depth[link] >= depth[state])
+                {
+                    return false;
+                }
+            }
+        }
+        //bits past the last state would be ranked to phrases no state ends
+        if (phraseIdx != tables.phraseCount || linkIdx != tables.outputLinkCount)
+        {
+            return false;
+        }
+        for (int label = 0; label < BYTE_VALUES; label++)
+        {
+            if (tables.rootNext[label] >= stateCount || depth[tables.rootNext[label]] > 1)
+            {
+                return false;
+            }
+        }
+        //phrases only add to a score, limits rely on scores never going down
+        for (phraseIdx = 0; phraseIdx < tables.phraseCount; phraseIdx++)
+        {
+            if (tables.phraseScore[phraseIdx] < 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief writes a table of a matcher as a constexpr array. c++ has no empty arrays, so an
+     * empty table is written as a single unused zero
+     * @param out the stream to write to
+     * @param typeName the element type of the table
+     * @param name the name of the array
+     * @param values the table
+     * @param count the number of entries in the table
+     */
+    template <typename ValueT>
+    void writeHeaderArray(std::ostream &out, const char *typeName, const char *name,
+                          const ValueT *values, size_t count)
+    {
+        out << "constexpr " << typeName << ' ' << name << "[] = {";
+        for (size_t valueIdx = 0; valueIdx < count; valueIdx++)
+        {
+            out << (valueIdx % HEADER_VALUES_PER_LINE == 0 ? "\n        " : " ")
+                << +values[valueIdx] << (sizeof(ValueT) == sizeof(uint64_t) ? "ULL" : "")
+                << ',';
+        }
+        out << (count == 0 ? "0};\n" : "\n};\n");
+    }
+
+    /**
+     * @brief writes a whole buffer to a descriptor, carrying on after partial writes and signals
+     * @param fd the descriptor to write to
+     * @param data the bytes to write
+     * @param size the number of bytes
+     * @return true if everything was written, false otherwise
+     */
+    bool writeAll(int fd, const char *data, size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t written = write(fd, data, size);
+            if (written < 0 && errno != EINTR)
+            {
+                return false;
+            }
+            if (written > 0)
+            {
+                data += written;
+                size -= (size_t) written;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief rounds a size up to the section alignment
+     */
+    uint64_t alignUp(uint64_t size)
+    {
+        return (size + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+    }
+}
+
+bool isDictionaryFile(const std::string &filePath)
+{
+    std::ifstream fileReader(filePath, std::ios::binary);
+    DictionaryHeader header;
+    return fileReader.read((char *) &header, sizeof(header)) && headerValid(header);
+}
+
+void writeDictionaryFile(const PhraseMatcher &matcher, const std::string &filePath)
+{
+    const PhraseMatcher::Tables &tables = matcher.tables();
+    const char *sectionData[SECTION_COUNT] = {
+            (const char *) tables.edgeStart, (const char *) tables.edgeLabel,
+            (const char *) tables.rootNext, (const char *) tables.fail,
+            (const char *) tables.terminalBits, (const char *) tables.terminalRank,
+            (const char *) tables.outputBits, (const char *) tables.outputRank,
+            (const char *) tables.outputLink, (const char *) tables.phraseLength,
+            (const char *) tables.phraseScore};
+    uint64_t sizes[SECTION_COUNT];
+    sectionSizes(tables, sizes);
+
+    DictionaryHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, DICTIONARY_MAGIC, MAGIC_SIZE);
+    header.version = DICTIONARY_VERSION;
+    header.byteOrderMark = BYTE_ORDER_MARK;
+    header.stateCount = tables.stateCount;
+    header.phraseCount = tables.phraseCount;
+    header.outputLinkCount = tables.outputLinkCount;
+    uint64_t offset = alignUp(sizeof(DictionaryHeader));
+    for (int section = 0; section < SECTION_COUNT; section++)
+    {
+        header.sections[section].offset = offset;
+        header.sections[section].byteSize = sizes[section];
+        offset = alignUp(offset + sizes[section]);
+    }
+    header.fileSize = offset;
+
+    //the payload is checksummed first, so the file is written front to back in one pass
+    const char padding[SECTION_ALIGNMENT] = {};
+    uint64_t checksum = FNV_OFFSET_BASIS;
+    for (int section = 0; section < SECTION_COUNT; section++)
+    {
+        checksum = fnv1a(checksum, sectionData[section], sizes[section]);
+        checksum = fnv1a(checksum, padding, alignUp(sizes[section]) - sizes[section]);
+    }
+    header.payloadChecksum = checksum;
+    header.headerChecksum = fnv1a(FNV_OFFSET_BASIS, (const char *) &header,
+                                  offsetof(DictionaryHeader, headerChecksum));
+
+    //a served dictionary stays mapped, so it's never written in place. the new file is written
+    //next to it under a temporary name and renamed over it once it's on disk, which leaves the
+    //mapped file intact and means a reload always maps a whole new file
+    std::string tempPath = filePath + TEMP_FILE_SUFFIX + std::to_string(getpid());
+    int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, DICTIONARY_FILE_MODE);
+    if (fd < 0)
+    {
+        throw std::runtime_error(DICTIONARY_WRITE_ERROR);
+    }
+    bool written = writeAll(fd, (const char *) &header, sizeof(header)) &&
+                   writeAll(fd, padding, header.sections[0].offset - sizeof(header));
+    for (int section = 0; section < SECTION_COUNT && written; section++)
+    {
+        written = writeAll(fd, sectionData[section], sizes[section]) &&
+                  writeAll(fd, padding, alignUp(sizes[section]) - sizes[section]);
+    }
+    written = written && fsync(fd) == 0;
+    written = close(fd) == 0 && written;
+    if (!written || rename(tempPath.c_str(), filePath.c_str()) != 0)
+    {
+        unlink(tempPath.c_str());
+        throw std::runtime_error(DICTIONARY_WRITE_ERROR);
+    }
+}
+
+void writeDictionaryHeader(const PhraseMatcher &matcher, const std::string &headerPath,
+                           const std::string &sourcePath)
+{
+    const PhraseMatcher::Tables &tables = matcher.tables();
+    size_t bitWords = PhraseMatcher::bitWordCount(tables.stateCount);
+    std::ofstream out(headerPath, std::ios::trunc);
+    out << "//generated from " << sourcePath << ", do not edit\n"
+        << "#include <cstdint>\n"
+        << "#include \"PhraseMatcher.hpp\"\n\n"
+        << "#ifndef EX3_BAKEDTABLES_HPP\n"
+        << "#define EX3_BAKEDTABLES_HPP\n\n"
+        << "namespace bakedTables\n{\n";
+    writeHeaderArray(out, "uint32_t", "EDGE_START", tables.edgeStart, tables.stateCount + 1);
+    writeHeaderArray(out, "unsigned char", "EDGE_LABEL", tables.edgeLabel,
+                     tables.stateCount - 1);
+    writeHeaderArray(out, "uint32_t", "ROOT_NEXT", tables.rootNext, BYTE_VALUES);
+    writeHeaderArray(out, "uint32_t", "FAIL", tables.fail, tables.stateCount);
+    writeHeaderArray(out, "uint64_t", "TERMINAL_BITS", tables.terminalBits, bitWords);
+    writeHeaderArray(out, "uint32_t", "TERMINAL_RANK", tables.terminalRank, bitWords);
+    writeHeaderArray(out, "uint64_t", "OUTPUT_BITS", tables.outputBits, bitWords);
+    writeHeaderArray(out, "uint32_t", "OUTPUT_RANK", tables.outputRank, bitWords);
+    writeHeaderArray(out, "uint32_t", "OUTPUT_LINK", tables.outputLink, tables.outputLinkCount);
+    writeHeaderArray(out, "uint32_t", "PHRASE_LENGTH", tables.phraseLength, tables.phraseCount);
+    writeHeaderArray(out, "int32_t", "PHRASE_SCORE", tables.phraseScore, tables.phraseCount);
+    out << "}\n\n"
+        << "constexpr PhraseMatcher::Tables BAKED_TABLES = {\n"
+        << "        " << tables.stateCount << ", " << tables.phraseCount << ", "
+        << tables.outputLinkCount << ",\n"
+        << "        bakedTables::EDGE_START, bakedTables::EDGE_LABEL, bakedTables::ROOT_NEXT,\n"
+        << "        bakedTables::FAIL, bakedTables::TERMINAL_BITS, bakedTables::TERMINAL_RANK,\n"
+        << "        bakedTables::OUTPUT_BITS, bakedTables::OUTPUT_RANK, bakedTables::OUTPUT_LINK,\n"
+        << "        bakedTables::PHRASE_LENGTH, bakedTables::PHRASE_SCORE};\n\n"
+        << "#endif //EX3_BAKEDTABLES_HPP\n";
+    out.close();
+    if (!out)
+    {
+        throw std::runtime_error(DICTIONARY_WRITE_ERROR);
+    }
+}
+
+PhraseMatcher loadDictionaryFile(const std::string &filePath, bool verifyPayload)
+{
+    std::shared_ptr<MappedFile> mapping = std::make_shared<MappedFile>(filePath);
+    if (mapping->size() < sizeof(DictionaryHeader))
+    {
+        throw std::invalid_argument(DICTIONARY_FORMAT_ERROR);
+    }
+    DictionaryHeader header;
+    std::memcpy(&header, mapping->data(), sizeof(header));
+    if (!headerValid(header) || header.fileSize != mapping->size())
+    {
+        throw std::invalid_argument(DICTIONARY_FORMAT_ERROR);
+    }
+
+    PhraseMatcher::Tables tables;
+    tables.stateCount = header.stateCount;
+    tables.phraseCount = header.phraseCount;
+    tables.outputLinkCount = header.outputLinkCount;
+    if (tables.stateCount == 0 || tables.stateCount > UINT32_MAX)
+    {
+        throw std::invalid_argument(DICTIONARY_FORMAT_ERROR);
+    }
+    uint64_t sizes[SECTION_COUNT];
+    sectionSizes(tables, sizes);
+    uint64_t payloadStart = header.sections[0].offset;
+    for (int section = 0; section < SECTION_COUNT; section++)
+    {
+        const SectionEntry &entry = header.sections[section];
+        if (entry.byteSize != sizes[section] || entry.offset % SECTION_ALIGNMENT != 0 ||
+            entry.offset < sizeof(DictionaryHeader) || entry.offset > header.fileSize ||
+            entry.byteSize > header.fileSize - entry.offset)
+        {
+            throw std::invalid_argument(DICTIONARY_FORMAT_ERROR);
+        }
+    }
+    if (verifyPayload && header.payloadChecksum !=
+                         fnv1a(FNV_OFFSET_BASIS, mapping->data() + payloadStart,
+                               header.fileSize - payloadStart))
+    {
+        throw std::invalid_argument(DICTIONARY_FORMAT_ERROR);
+    }
+
+    const char *base = mapping->data();
+    tables.edgeStart = (const uint32_t *) (base + header.sections[EDGE_START].offset);
+    tables.edgeLabel = (const unsigned char *) (base + header.sections[EDGE_LABEL].offset);
+    tables.rootNext = (const uint32_t *) (base + header.sections[ROOT_NEXT].offset);
+    tables.fail = (const uint32_t *) (base + header.sections[FAIL].offset);
+    tables.terminalBits = (const uint64_t *) (base + header.sections[TERMINAL_BITS].offset);
+    tables.terminalRank = (const uint32_t *) (base + header.sections[TERMINAL_RANK].offset);
+    tables.outputBits = (const uint64_t *) (base + header.sections[OUTPUT_BITS].offset);
+    tables.outputRank = (const uint32_t *) (base + header.sections[OUTPUT_RANK].offset);
+    tables.outputLink = (const uint32_t *) (base + header.sections[OUTPUT_LINK].offset);
+    tables.phraseLength = (const uint32_t *) (base + header.sections[PHRASE_LENGTH].offset);
+    tables.phraseScore = (const int32_t *) (base + header.sections[PHRASE_SCORE].offset);
+    if (!tableValuesValid(tables))
+    {
+        throw std::invalid_argument(DICTIONARY_FORMAT_ERROR);
+    }
+    return PhraseMatcher(tables, mapping);
+}
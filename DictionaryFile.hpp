@@ -0,0 +1,58 @@
+#include <string>
+#include <cstdint>
+#include "PhraseMatcher.hpp"
+
+#ifndef EX3_DICTIONARYFILE_HPP
+#define EX3_DICTIONARYFILE_HPP
+
+#define DICTIONARY_MAGIC "SPAMDICT"
+#define DICTIONARY_FORMAT_ERROR "Invalid compiled dictionary"
+#define DICTIONARY_WRITE_ERROR "Could not write compiled dictionary"
+
+const uint32_t DICTIONARY_VERSION = 2;
+
+/**
+ * @brief checks if a file is a compiled dictionary, by its whole header: the magic bytes, the
+ * version, the byte order mark and the header checksum. a csv database that happens to start
+ * with the magic bytes fails the checksum, so it's still read as csv
+ * @param filePath the path of the file
+ * @return true if the file starts with a valid dictionary header, false otherwise
+ */
+bool isDictionaryFile(const std::string &filePath);
+
+/**
+ * @brief writes the tables of a matcher into a compiled dictionary file. the file holds a
+ * versioned header followed by every table, 8 byte aligned, so it can be mapped and used as is.
+ * the header and the payload each carry an FNV-1a checksum. an existing file is replaced in a
+ * single rename once the new one is complete, so a server that has it mapped is never affected
+ * @param matcher the matcher to write
+ * @param filePath the path of the file to create
+ * @throw std::runtime_error if the file can't be written
+ */
+void writeDictionaryFile(const PhraseMatcher &matcher, const std::string &filePath);
+
+/**
+ * @brief writes the tables of a matcher as a c++ header, to be compiled into a binary. every
+ * table is a constexpr array and the header defines a constexpr PhraseMatcher::Tables named
+ * BAKED_TABLES over them, so a matcher over it needs no file or allocation
+ * @param matcher the matcher to write
+ * @param headerPath the path of the header to create
+ * @param sourcePath the database the matcher was built from, only noted in the header
+ * @throw std::runtime_error if the file can't be written
+ */
+void writeDictionaryHeader(const PhraseMatcher &matcher, const std::string &headerPath,
+                           const std::string &sourcePath);
+
+/**
+ * @brief maps a compiled dictionary file and builds a matcher over it, without copying or
+ * parsing the tables. the header checksum, the layout of the tables and every value the scanner
+ * indexes with are always checked, so a corrupted file is refused rather than scanned. checking
+ * the payload checksum reads the whole file and so is optional
+ * @param filePath the path of the file
+ * @param verifyPayload true to check the payload checksum too
+ * @return a matcher that keeps the file mapped for as long as it exists
+ * @throw std::invalid_argument if the file isn't a valid compiled dictionary
+ */
+PhraseMatcher loadDictionaryFile(const std::string &filePath, bool verifyPayload);
+
+#endif //EX3_DICTIONARYFILE_HPP
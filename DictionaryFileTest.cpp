@@ -0,0 +1,312 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+#include "HashMap.hpp"
+#include "PhraseMatcher.hpp"
+#include "DictionaryFile.hpp"
+#include "DatabaseLoader.hpp"
+#include "StringPool.hpp"
+#include "TestCheck.hpp"
+
+const char *const TEST_DICTIONARY_PATH = "dictionary_file_test.bin";
+const char *const TEST_CSV_PATH = "dictionary_file_test.csv";
+const size_t TEST_HEADER_BYTE = 20;
+const int BYTE_VALUES = 256;
+
+/**
+ * @brief a copy of the tables of a matcher that a test may change, to write a corrupted
+ * dictionary through the same writer as a valid one
+ */
+struct TableCopy
+{
+    explicit TableCopy(const PhraseMatcher::Tables &source) : tables(source)
+    {
+        size_t stateCount = source.stateCount;
+        size_t bitWords = PhraseMatcher::bitWordCount(stateCount);
+        edgeStart.assign(source.edgeStart, source.edgeStart + stateCount + 1);
+        edgeLabel.assign(source.edgeLabel, source.edgeLabel + stateCount - 1);
+        rootNext.assign(source.rootNext, source.rootNext + BYTE_VALUES);
+        fail.assign(source.fail, source.fail + stateCount);
+        terminalBits.assign(source.terminalBits, source.terminalBits + bitWords);
+        terminalRank.assign(source.terminalRank, source.terminalRank + bitWords);
+        outputBits.assign(source.outputBits, source.outputBits + bitWords);
+        outputRank.assign(source.outputRank, source.outputRank + bitWords);
+        outputLink.assign(source.outputLink, source.outputLink + source.outputLinkCount);
+        phraseLength.assign(source.phraseLength, source.phraseLength + source.phraseCount);
+        phraseScore.assign(source.phraseScore, source.phraseScore + source.phraseCount);
+        tables.edgeStart = edgeStart.data();
+        tables.edgeLabel = edgeLabel.data();
+        tables.rootNext = rootNext.data();
+        tables.fail = fail.data();
+        tables.terminalBits = terminalBits.data();
+        tables.terminalRank = terminalRank.data();
+        tables.outputBits = outputBits.data();
+        tables.outputRank = outputRank.data();
+        tables.outputLink = outputLink.data();
+        tables.phraseLength = phraseLength.data();
+        tables.phraseScore = phraseScore.data();
+    }
+
+    /**
+     * @return the depth of every state, counted along the edges
+     */
+    std::vector<uint32_t> depths() const
+    {
+        std::vector<uint32_t> depth(tables.stateCount, 0);
+        for (size_t state = 0; state < tables.stateCount; state++)
+        {
+            for (uint32_t edge = edgeStart[state]; edge < edgeStart[state + 1]; edge++)
+            {
+                depth[edge + 1] = depth[state] + 1;
+            }
+        }
+        return depth;
+    }
+
+    PhraseMatcher::Tables tables;
+    std::vector<uint32_t> edgeStart;
+    std::vector<unsigned char> edgeLabel;
+    std::vector<uint32_t> rootNext;
+    std::vector<uint32_t> fail;
+    std::vector<uint64_t> terminalBits;
+    std::vector<uint32_t> terminalRank;
+    std::vector<uint64_t> outputBits;
+    std::vector<uint32_t> outputRank;
+    std::vector<uint32_t> outputLink;
+    std::vector<uint32_t> phraseLength;
+    std::vector<int32_t> phraseScore;
+};
+
+/**
+ * @param phrases the phrases of the matcher, scored by their index plus one
+ * @return a matcher over the phrases
+ */
+PhraseMatcher makeMatcher(const std::vector<std::string> &phrases)
+{
+    HashMap<std::string_view, int> scoreMap;
+    for (size_t phraseIdx = 0; phraseIdx < phrases.size(); phraseIdx++)
+    {
+        scoreMap.insert(phrases[phraseIdx], (int) phraseIdx + 1);
+    }
+    return PhraseMatcher(scoreMap);
+}
+
+/**
+ * @param path the path of a file
+ * @return the bytes of the file
+ */
+std::string readBytes(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+/**
+ * @param path the path of the file to create
+ * @param bytes the bytes to write into it
+ */
+void writeBytes(const std::string &path, const std::string &bytes)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), (std::streamsize) bytes.size());
+}
+
+/**
+ * @param first a table
+ * @param second another table
+ * @param count the number of entries of both
+ * @return true if the tables hold the same entries, false otherwise
+ */
+template <typename ValueT>
+bool sameTable(const ValueT *first, const ValueT *second, size_t count)
+{
+    return count == 0 || std::memcmp(first, second, count * sizeof(ValueT)) == 0;
+}
+
+/**
+ * @brief writes tables into a dictionary and checks that loading it is refused
+ * @param copy the corrupted tables
+ * @param name the name of the check
+ */
+void checkRefused(const TableCopy &copy, const std::string &name)
+{
+    writeDictionaryFile(PhraseMatcher(copy.tables, nullptr), TEST_DICTIONARY_PATH);
+    checkThrows([] { loadDictionaryFile(TEST_DICTIONARY_PATH, false); }, name);
+}
+
+/**
+ * @brief a written dictionary loads back into the same tables, and scores the same as the
+ * matcher it was written from
+ */
+void testRoundTrip()
+{
+    std::vector<std::string> phrases = {"free", "free money", "money", "aa", "aaa", "ab", "ba",
+                                        "win a prize", "prize", "click here", "a", "here"};
+    PhraseMatcher matcher = makeMatcher(phrases);
+    writeDictionaryFile(matcher, TEST_DICTIONARY_PATH);
+    check(isDictionaryFile(TEST_DICTIONARY_PATH), "a written dictionary is recognised");
+    PhraseMatcher loaded = loadDictionaryFile(TEST_DICTIONARY_PATH, true);
+    const PhraseMatcher::Tables &written = matcher.tables();
+    const PhraseMatcher::Tables &read = loaded.tables();
+    size_t bitWords = PhraseMatcher::bitWordCount(written.stateCount);
+    bool same = written.stateCount == read.stateCount && written.phraseCount == read.phraseCount &&
+                written.outputLinkCount == read.outputLinkCount &&
+                sameTable(written.edgeStart, read.edgeStart, written.stateCount + 1) &&
+                sameTable(written.edgeLabel, read.edgeLabel, written.stateCount - 1) &&
+                sameTable(written.rootNext, read.rootNext, BYTE_VALUES) &&
+                sameTable(written.fail, read.fail, written.stateCount) &&
+                sameTable(written.terminalBits, read.terminalBits, bitWords) &&
+                sameTable(written.terminalRank, read.terminalRank, bitWords) &&
+                sameTable(written.outputBits, read.outputBits, bitWords) &&
+                sameTable(written.outputRank, read.outputRank, bitWords) &&
+                sameTable(written.outputLink, read.outputLink, written.outputLinkCount) &&
+                sameTable(written.phraseLength, read.phraseLength, written.phraseCount) &&
+                sameTable(written.phraseScore, read.phraseScore, written.phraseCount);
+    check(same, "a loaded dictionary has the tables it was written with");
+    std::vector<std::string> texts = {"FREE money, free MONEY!\nclick here to win a prize\n",
+                                      "aaaaaaa\nabababa\nbaab", "", "\n\n\nhere", "nothing"};
+    PhraseMatcher::ScanState writtenState(matcher);
+    PhraseMatcher::ScanState readState(loaded);
+    bool sameScores = true;
+    for (const auto &text : texts)
+    {
+        sameScores = sameScores && matcher.scoreText(text, writtenState) ==
+                                   loaded.scoreText(text, readState);
+    }
+    check(sameScores, "a loaded dictionary scores the same as its matcher");
+
+    //writing again replaces the file, and a matcher over the old one is unaffected
+    writeDictionaryFile(makeMatcher({"other"}), TEST_DICTIONARY_PATH);
+    check(loaded.scoreText("free", readState) == 1, "a replaced dictionary stays mapped");
+    PhraseMatcher replaced = loadDictionaryFile(TEST_DICTIONARY_PATH, true);
+    check(replaced.phraseCount() == 1, "loading a replaced dictionary reads the new one");
+}
+
+/**
+ * @brief damaged files are refused rather than scanned
+ */
+void testDamagedFiles()
+{
+    writeDictionaryFile(makeMatcher({"spam", "ham", "eggs and spam"}), TEST_DICTIONARY_PATH);
+    std::string valid = readBytes(TEST_DICTIONARY_PATH);
+
+    writeBytes(TEST_DICTIONARY_PATH, valid.substr(0, valid.size() - 1));
+    checkThrows([] { loadDictionaryFile(TEST_DICTIONARY_PATH, false); },
+                "a truncated dictionary is refused");
+    writeBytes(TEST_DICTIONARY_PATH, valid.substr(0, TEST_HEADER_BYTE));
+    checkThrows([] { loadDictionaryFile(TEST_DICTIONARY_PATH, false); },
+                "a dictionary cut inside its header is refused");
+
+    std::string damaged = valid;
+    damaged[TEST_HEADER_BYTE] ^= 1;
+    writeBytes(TEST_DICTIONARY_PATH, damaged);
+    checkThrows([] { loadDictionaryFile(TEST_DICTIONARY_PATH, false); },
+                "a dictionary with a damaged header is refused");
+
+    damaged = valid;
+    damaged[damaged.size() - 1] ^= 1;
+    writeBytes(TEST_DICTIONARY_PATH, damaged);
+    checkThrows([] { loadDictionaryFile(TEST_DICTIONARY_PATH, true); },
+                "a damaged payload fails the payload checksum");
+
+    checkThrows([] { loadDictionaryFile("missing_dictionary_file_test.bin", false); },
+                "a missing dictionary is refused");
+}
+
+/**
+ * @brief tables that pass the checksums but hold values the scanner can't follow are refused
+ */
+void testCorruptedTables()
+{
+    PhraseMatcher matcher = makeMatcher({"ab", "xy", "abcd", "bc"});
+    TableCopy tables(matcher.tables());
+    std::vector<uint32_t> depth = tables.depths();
+
+    TableCopy longer(matcher.tables());
+    longer.phraseLength[0] += 1;
+    checkRefused(longer, "a phrase longer than the depth of its state is refused");
+    TableCopy shorter(matcher.tables());
+    shorter.phraseLength[tables.tables.phraseCount - 1] -= 1;
+    checkRefused(shorter, "a phrase shorter than the depth of its state is refused");
+
+    //"ab" and "xy" are states of the same depth, next to each other in breadth first order
+    size_t state = 2;
+    while (state < depth.size() && depth[state - 1] != depth[state])
+    {
+        state++;
+    }
+    TableCopy sideways(matcher.tables());
+    sideways.fail[state] = (uint32_t) state - 1;
+    checkRefused(sideways, "a failure link to a state as deep as its own is refused");
+    TableCopy loop(matcher.tables());
+    loop.fail[state] = (uint32_t) state;
+    checkRefused(loop, "a failure link to itself is refused");
+
+    TableCopy deepRoot(matcher.tables());
+    deepRoot.rootNext['a'] = (uint32_t) (depth.size() - 1);
+    checkRefused(deepRoot, "a root transition past the first level is refused");
+    TableCopy outside(matcher.tables());
+    outside.rootNext['a'] = (uint32_t) depth.size();
+    checkRefused(outside, "a root transition outside the states is refused");
+
+    TableCopy backwards(matcher.tables());
+    backwards.edgeStart[1] = 0;
+    checkRefused(backwards, "edges leading to an earlier state are refused");
+    TableCopy rank(matcher.tables());
+    rank.terminalRank[0] = 1;
+    checkRefused(rank, "a rank that doesn't count its bits is refused");
+    TableCopy negative(matcher.tables());
+    negative.phraseScore[0] = -1;
+    checkRefused(negative, "a negative score is refused");
+
+    writeDictionaryFile(PhraseMatcher(tables.tables, nullptr), TEST_DICTIONARY_PATH);
+    check(loadDictionaryFile(TEST_DICTIONARY_PATH, true).phraseCount() == 4,
+          "an unchanged copy of the tables loads");
+}
+
+/**
+ * @brief a file is only taken for a compiled dictionary by its whole header, so a csv database
+ * that starts with the magic bytes is still read as csv
+ */
+void testFormatDetection()
+{
+    writeBytes(TEST_CSV_PATH, std::string(DICTIONARY_MAGIC) + " free,3\nmoney,2\n");
+    check(!isDictionaryFile(TEST_CSV_PATH), "a csv database starting with the magic is csv");
+    std::vector<std::string_view> words;
+    std::vector<int> scores;
+    StringPool pool;
+    readFileIntoVectors(words, scores, pool, TEST_CSV_PATH);
+    check(words.size() == 2 && words[0] == "spamdict free" && scores[0] == 3,
+          "a csv database starting with the magic parses");
+
+    writeBytes(TEST_CSV_PATH, std::string(DICTIONARY_MAGIC));
+    check(!isDictionaryFile(TEST_CSV_PATH), "the magic alone isn't a dictionary");
+    check(!isDictionaryFile("missing_dictionary_file_test.bin"),
+          "a missing file isn't a dictionary");
+
+    writeDictionaryFile(makeMatcher({"spam"}), TEST_DICTIONARY_PATH);
+    std::string damaged = readBytes(TEST_DICTIONARY_PATH);
+    damaged[TEST_HEADER_BYTE] ^= 1;
+    writeBytes(TEST_DICTIONARY_PATH, damaged);
+    check(!isDictionaryFile(TEST_DICTIONARY_PATH), "a damaged header isn't a dictionary");
+}
+
+/**
+ * @brief runs the tests of compiled dictionary files
+ * @return 0 if all checks passed, exit failure constant otherwise
+ */
+int main()
+{
+    testRoundTrip();
+    testDamagedFiles();
+    testCorruptedTables();
+    testFormatDetection();
+    std::remove(TEST_DICTIONARY_PATH);
+    std::remove(TEST_CSV_PATH);
+    return checkResult();
+}
@@ -2,7 +2,18 @@
 // Created by guyna25 on 16/01/2020.
 //
 #include <vector>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <stdexcept>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <new>
+#include <tuple>
+#include <cstdint>
+#include <cstring>
 
 #ifndef EX3_HASHMAP_HPP
 #define EX3_HASHMAP_HPP
@@ -11,35 +22,263 @@
 #define NONEXISTANT_KEY_ERR "This key does not exist in the map"
 
 const int START_CAPACITY = 16;
+const int MIN_CAPACITY = 1;
 const int RESIZE_FACTOR = 2;
 const int ELEMENT_NUMBER = 0;
 const double DEFAULT_UPPER_LOAD_FACTOR = 0.75;
 const double DEFAULT_LOWER_LOAD_FACTOR = 0.25;
 const int ERROR_CODE = -1;
+const uint32_t EMPTY_SLOT = 0;
+//odd constants with well spread bits, from wyhash
+const uint64_t HASH_SEED = 0xa0761d6478bd642fULL;
+const uint64_t HASH_MULTIPLIER = 0xe7037ed1a0b428dbULL;
 
 /**
- * @brief This class represents a generic hash map
+ * @brief multiplies two words into 128 bits and folds the halves together, so every bit of the
+ * inputs reaches the low bits of the result
+ * @param first the first word
+ * @param second the second word
+ * @return the folded product
+ */
+inline uint64_t foldMultiply(uint64_t first, uint64_t second)
+{
+    unsigned __int128 product = (unsigned __int128) first * second;
+    return (uint64_t) product ^ (uint64_t) (product >> 64);
+}
+
+/**
+ * @brief hashes bytes a word at a time with a multiply per word. much faster than the standard
+ * string hash for the short phrases of a dictionary, and well mixed in the low bits a home slot is
+ * taken from
+ * @param bytes the bytes to hash
+ * @param size the number of bytes
+ * @return the hash of the bytes
+ */
+inline size_t hashBytes(const char *bytes, size_t size)
+{
+    uint64_t hash = HASH_SEED ^ size;
+    uint64_t word;
+    for (; size >= sizeof(word); size -= sizeof(word), bytes += sizeof(word))
+    {
+        std::memcpy(&word, bytes, sizeof(word));
+        hash = foldMultiply(hash ^ word, HASH_MULTIPLIER);
+    }
+    //the last few bytes are read with fixed size loads, a variable sized copy is a library call
+    if (size >= sizeof(uint32_t))
+    {
+        uint32_t first;
+        uint32_t last;
+        std::memcpy(&first, bytes, sizeof(first));
+        std::memcpy(&last, bytes + size - sizeof(last), sizeof(last));
+        word = ((uint64_t) first << 32) | last;
+    }
+    else
+    {
+        word = size == 0 ? 0 : ((uint64_t) (unsigned char) bytes[0] << 16) |
+                               ((uint64_t) (unsigned char) bytes[size / 2] << 8) |
+                               (unsigned char) bytes[size - 1];
+    }
+    return foldMultiply(hash ^ word ^ HASH_MULTIPLIER, HASH_SEED ^ HASH_MULTIPLIER);
+}
+
+/**
+ * @brief the default hash of HashMap. a standard hash is mixed once more, since some of them,
+ * like the hash of an int, leave the low bits a home slot is taken from poorly spread
+ * @tparam KeyT the key type to hash
+ */
+template <typename KeyT>
+struct HashMapHash
+{
+    size_t operator()(const KeyT &key) const
+    {
+        return foldMultiply(std::hash<KeyT>{}(key) ^ HASH_SEED, HASH_MULTIPLIER);
+    }
+};
+
+/**
+ * @brief strings are hashed as string views, so a string key can be looked up by a
+ * std::string_view or a c string without building a std::string, and to the same hash
+ */
+template <>
+struct HashMapHash<std::string>
+{
+    size_t operator()(std::string_view key) const
+    {
+        return hashBytes(key.data(), key.size());
+    }
+};
+
+template <>
+struct HashMapHash<std::string_view> : HashMapHash<std::string>
+{
+};
+
+/**
+ * @brief enables a lookup method of a map for key types other than its own, which are only
+ * string views and c strings when the keys are std::string
+ * @tparam KeyT the key of the map
+ * @tparam LookupT the type the map is looked up by
+ */
+template <typename KeyT, typename LookupT>
+using EnableTransparentLookup = std::enable_if_t<std::is_same<KeyT, std::string>::value &&
+                                                 !std::is_same<std::decay_t<LookupT>,
+                                                               KeyT>::value &&
+                                                 std::is_convertible<const LookupT &,
+                                                                     std::string_view>::value,
+                                                 int>;
+
+/**
+ * @brief a snapshot of how the pairs of a HashMap are laid out, for spotting bad hash
+ * distributions and tuning the load factors
+ */
+struct HashMapStats
+{
+    int size = 0;
+    int capacity = 0;
+    double loadFactor = 0;
+    //entry i is the number of home slots that i pairs hash to
+    std::vector<int> bucketHistogram;
+    //entry i is the number of pairs i slots away from their home slot
+    std::vector<int> probeHistogram;
+    //probe lengths count the slots a lookup of the pair reads, so a pair in its home slot has 1
+    int maxProbeLength = 0;
+    double averageProbeLength = 0;
+    int rehashCount = 0;
+    //the table itself, not counting memory owned by the keys and values
+    size_t bytesAllocated = 0;
+    //pairs that didn't get their home slot
+    int collisions = 0;
+};
+
+/**
+ * @brief This class represents a generic hash map.
+ * pairs are kept in one flat array using open addressing with Robin Hood probing: every slot
+ * records how far its pair is from its home slot, an inserted pair takes the place of a pair
+ * closer to its home, and erasing shifts the following pairs back. this keeps probe sequences
+ * short and lets a lookup stop as soon as it reaches a pair closer to home than itself.
+ * the full hash of every pair is kept next to it, so growing or copying the table never hashes a
+ * key again, and a lookup only compares keys whose hash is equal to its own
  * @tparam KeyT the key of a pair in the map
  * @tparam ValueT the value of the said pair
+ * @tparam HashT the hash of the keys. for string keys it's also called with the string views
+ * and c strings they are looked up by, which must hash the same as the equal key
  */
-template <typename  KeyT, typename ValueT>
+template <typename  KeyT, typename ValueT, typename HashT = HashMapHash<KeyT>>
 class HashMap
 {
 private:
+    typedef std::pair<KeyT, ValueT> pair_type;
+
     int _size = ELEMENT_NUMBER;
     int _capacity = START_CAPACITY;
+    int _rehashCount = 0;
     double _upperLoadFactor;
     double _lowerLoadFactor;
-    std::vector<std::pair<KeyT, ValueT>> *_buckets;
+    pair_type *_slots = nullptr;
+    //distance of the pair in each slot from its home slot plus one, or the empty slot constant
+    uint32_t *_probeLengths = nullptr;
+    //the hash of the key in each occupied slot
+    size_t *_hashes = nullptr;
+
+    /**
+     * @param key the key to hash
+     * @return the full hash of the key
+     */
+    template <typename LookupT>
+    static size_t _hash(const LookupT &key)
+    {
+        return HashT{} (key);
+    }
 
     /**
-     * @brief getter method for key hash code
-     * @param key the key to use
-     * @return hash code for the key
+     * @brief getter method for the home slot of a hash
+     * @param hash the full hash of a key
+     * @return the index of the home slot of the key
      */
-    int _getHashCode(const KeyT &key) const
+    int _homeSlot(size_t hash) const
     {
-        return std::hash<KeyT>{} (key) & (capacity() - 1);
+        return (int) (hash & (size_t) (capacity() - 1));
+    }
+
+    /**
+     * @brief allocates an empty table of the current capacity
+     */
+    void _allocateTable()
+    {
+        pair_type *slots = static_cast<pair_type *>(::operator new(sizeof(pair_type) * _capacity));
+        uint32_t *probeLengths = nullptr;
+        size_t *hashes = nullptr;
+        try
+        {
+            probeLengths = new uint32_t[_capacity]();
+            hashes = new size_t[_capacity];
+        }
+        catch (std::bad_alloc &error)
+        {
+            delete[] probeLengths;
+            ::operator delete(slots);
+            throw error; //move up call stack
+        }
+        _slots = slots;
+        _probeLengths = probeLengths;
+        _hashes = hashes;
+    }
+
+    /**
+     * @brief destroys all pairs and frees the table
+     */
+    void _freeTable()
+    {
+        if (_slots == nullptr)
+        {
+            return;
+        }
+        for (int slotIdx = 0; slotIdx < _capacity; slotIdx++)
+        {
+            if (_probeLengths[slotIdx] != EMPTY_SLOT)
+            {
+                _slots[slotIdx].~pair_type();
+            }
+        }
+        ::operator delete(_slots);
+        delete[] _probeLengths;
+        delete[] _hashes;
+        _slots = nullptr;
+        _probeLengths = nullptr;
+        _hashes = nullptr;
+    }
+
+    /**
+     * @brief places a pair whose key is known not to be in the table. assumes there is a free
+     * slot
+     * @param pair the pair to place
+     * @param hash the hash of the key of the pair
+     * @return the slot the pair was placed in
+     */
+    int _place(pair_type &&pair, size_t hash)
+    {
+        int slotIdx = _homeSlot(hash);
+        uint32_t probeLength = 1;
+        int placedIdx = ERROR_CODE;
+        while (_probeLengths[slotIdx] != EMPTY_SLOT)
+        {
+            if (_probeLengths[slotIdx] < probeLength) //the resident is closer to home, so it moves
+            {
+                std::swap(pair, _slots[slotIdx]);
+                std::swap(probeLength, _probeLengths[slotIdx]);
+                std::swap(hash, _hashes[slotIdx]);
+                if (placedIdx == ERROR_CODE)
+                {
+                    placedIdx = slotIdx;
+                }
+            }
+            slotIdx = (slotIdx + 1) & (capacity() - 1);
+            probeLength++;
+        }
+        new(&_slots[slotIdx]) pair_type(std::move(pair));
+        _probeLengths[slotIdx] = probeLength;
+        _hashes[slotIdx] = hash;
+        return placedIdx == ERROR_CODE ? slotIdx : placedIdx;
     }
 
     /**
@@ -51,7 +290,7 @@ private:
         {
             this->_resize(true);
         }
-        if ((double) size() / capacity() <  _lowerLoadFactor)
+        if ((double) size() / capacity() <  _lowerLoadFactor && capacity() > MIN_CAPACITY)
         {
             this->_resize(false);
         }
@@ -73,19 +312,12 @@ private:
         }
         else
         {
-            while((double) size() / capacity() < _lowerLoadFactor)
+            while((double) size() / capacity() < _lowerLoadFactor && capacity() > MIN_CAPACITY)
             {
                 this->_capacity /= RESIZE_FACTOR;
             }
         }
-        try
-        {
-            this->_rehash(previousCapacity);
-        }
-        catch (std::bad_alloc &ex)
-        {
-            throw ex;
-        }
+        this->_rehash(previousCapacity);
     }
 
     /**
@@ -94,46 +326,173 @@ private:
      */
     void _rehash(int previousCapacity)
     {
+        pair_type *oldSlots = _slots;
+        uint32_t *oldProbeLengths = _probeLengths;
+        size_t *oldHashes = _hashes;
         try
         {
-            auto *newTable = new std::vector<std::pair<KeyT, ValueT>>[_capacity];
-            for (int bucketIdx = 0; bucketIdx < previousCapacity; bucketIdx++)
+            _allocateTable();
+        }
+        catch (std::bad_alloc &ex) //the old table is still in place
+        {
+            _capacity = previousCapacity;
+            throw ex;
+        }
+        _rehashCount++;
+        for (int slotIdx = 0; slotIdx < previousCapacity; slotIdx++)
+        {
+            if (oldProbeLengths[slotIdx] != EMPTY_SLOT)
             {
-                int currHashCode;
-                for (auto pair : this->_buckets[bucketIdx])
-                {
-                    currHashCode = _getHashCode(pair.first);
-                    newTable[currHashCode].push_back(pair);
-                }
+                _place(std::move(oldSlots[slotIdx]), oldHashes[slotIdx]); //the kept hash is reused
+                oldSlots[slotIdx].~pair_type();
             }
-            delete[] _buckets;
-            this->_buckets = newTable;
         }
-        catch (std::bad_alloc &ex)
+        if (oldSlots != nullptr)
         {
-            throw ex;
+            ::operator delete(oldSlots);
+            delete[] oldProbeLengths;
+            delete[] oldHashes;
+        }
+    }
+
+    /**
+     * @return a shared probe table of the minimum capacity that is always empty. a moved from map
+     * points at it, so it stays usable without owning any memory
+     */
+    static uint32_t *_emptyProbeLengths()
+    {
+        static uint32_t emptyProbeLengths[MIN_CAPACITY] = {EMPTY_SLOT};
+        return emptyProbeLengths;
+    }
+
+    /**
+     * @brief leaves this map empty and without a table of its own
+     */
+    void _becomeEmpty()
+    {
+        _size = 0;
+        _capacity = MIN_CAPACITY;
+        _slots = nullptr;
+        _probeLengths = _emptyProbeLengths();
+        _hashes = nullptr;
+    }
+
+    /**
+     * @brief swaps the contents of two maps
+     * @param other the map to swap with
+     */
+    void _swap(HashMap &other)
+    {
+        std::swap(_size, other._size);
+        std::swap(_capacity, other._capacity);
+        std::swap(_rehashCount, other._rehashCount);
+        std::swap(_upperLoadFactor, other._upperLoadFactor);
+        std::swap(_lowerLoadFactor, other._lowerLoadFactor);
+        std::swap(_slots, other._slots);
+        std::swap(_probeLengths, other._probeLengths);
+        std::swap(_hashes, other._hashes);
+    }
+
+    /**
+     * @brief adds a pair, or replaces the value of its key if the key is already in the table
+     * @param pair the pair to add
+     */
+    void _insertOrAssign(pair_type &&pair)
+    {
+        size_t hash = _hash(pair.first);
+        int slotIdx = _findSlot(pair.first, hash);
+        if (slotIdx == ERROR_CODE)
+        {
+            _insertNew(std::move(pair), hash);
         }
+        else
+        {
+            _slots[slotIdx].second = std::move(pair.second);
+        }
+    }
+
+    /**
+     * @brief getter method for the slot of a key
+     * @param key the key to get the slot for
+     * @return the index of the slot holding the key, or the error code if it's not in the table
+     */
+    template <typename LookupT>
+    int _findSlot(const LookupT &key) const
+    {
+        return _findSlot(key, _hash(key));
     }
 
     /**
-     * @brief getter method for key index in a bucket
-     * @param key the key to get the index for
-     * @return the index of the key in the relevant bucket
+     * @brief getter method for the slot of a key whose hash is already known
+     * @param key the key to get the slot for
+     * @param hash the hash of the key
+     * @return the index of the slot holding the key, or the error code if it's not in the table
      */
-    int _getInnerKeyIdx(const KeyT key) const
+    template <typename LookupT>
+    int _findSlot(const LookupT &key, size_t hash) const
     {
-        std::vector<std::pair<KeyT, ValueT>> relevantVec = _buckets[_getHashCode(key)];
-        for (size_t vecIdx = 0; vecIdx < relevantVec.size(); vecIdx++)
+        int slotIdx = _homeSlot(hash);
+        uint32_t probeLength = 1;
+        //a pair closer to its home than the probe means the key would have been placed before it
+        while (_probeLengths[slotIdx] >= probeLength)
         {
-            if (relevantVec[vecIdx].first == key)
+            //keys of another hash are told apart without reading the pair
+            if (_hashes[slotIdx] == hash && _slots[slotIdx].first == key)
             {
-                return vecIdx;
+                return slotIdx;
             }
+            slotIdx = (slotIdx + 1) & (capacity() - 1);
+            probeLength++;
         }
         return ERROR_CODE;
     }
 
+    /**
+     * @brief adds a pair whose key is known not to be in the table, growing the table if needed
+     * @param pair the pair to add
+     * @param hash the hash of the key of the pair
+     * @return the slot the pair was placed in
+     */
+    int _insertNew(pair_type &&pair, size_t hash)
+    {
+        _size++;
+        if ((double) size() / capacity() > _upperLoadFactor)
+        {
+            try
+            {
+                _resize(true);
+            }
+            catch (std::bad_alloc &error)
+            {
+                _size--;
+                throw error; //move up call stack
+            }
+        }
+        return _place(std::move(pair), hash);
+    }
+
+    /**
+     * @brief removes the pair in a slot, shifting the pairs after it back towards their homes
+     * @param slotIdx the slot to empty
+     */
+    void _eraseSlot(int slotIdx)
+    {
+        _slots[slotIdx].~pair_type();
+        int nextIdx = (slotIdx + 1) & (capacity() - 1);
+        while (_probeLengths[nextIdx] > 1)
+        {
+            new(&_slots[slotIdx]) pair_type(std::move(_slots[nextIdx]));
+            _slots[nextIdx].~pair_type();
+            _probeLengths[slotIdx] = _probeLengths[nextIdx] - 1;
+            _hashes[slotIdx] = _hashes[nextIdx];
+            slotIdx = nextIdx;
+            nextIdx = (nextIdx + 1) & (capacity() - 1);
+        }
+        _probeLengths[slotIdx] = EMPTY_SLOT;
+    }
+
 public:
+    class hashMapIterator;
 
     /**
      * @brief default constructor for this class
@@ -142,53 +501,64 @@ public:
     {
         _upperLoadFactor = DEFAULT_UPPER_LOAD_FACTOR;
         _lowerLoadFactor = DEFAULT_LOWER_LOAD_FACTOR;
-        try
-        {
-            this->_buckets = new std::vector<std::pair<KeyT, ValueT>>[_capacity];
-        }
-        catch (std::bad_alloc &error)
-        {
-            throw error; //move up call stack
-        }
+        _allocateTable();
     }
 
     /**
      * @brief Constructor for this class that accepts a group of pairs. pair's index is assumed
-     * to be matching and amount of keys should be equal to values
+     * to be matching and amount of keys should be equal to values. a key that appears more than
+     * once keeps its last value
      * @param keys the keys for the group
      * @param values the values of the pairs
      */
     HashMap(std::vector<KeyT> keys, std::vector<ValueT> values) : HashMap()
     {
-        _upperLoadFactor = DEFAULT_UPPER_LOAD_FACTOR;
-        _lowerLoadFactor = DEFAULT_LOWER_LOAD_FACTOR;
-        try
+        if (keys.size() != values.size())
         {
-            if (keys.size() != values.size())
-            {
-                throw std::invalid_argument(KEYS_AND_VALUES_SIZE_DIFF);
-            }
-            for (size_t elementIdx = 0; elementIdx < keys.size(); elementIdx++)
-            {
-                if (containsKey(keys[elementIdx]))
-                {
-                    this->erase(keys[elementIdx]);
-                }
-                insert(keys[elementIdx], values[elementIdx]);
-            }
-
+            throw std::invalid_argument(KEYS_AND_VALUES_SIZE_DIFF);
         }
-        catch (const std::invalid_argument &ex)
+        reserve(keys.size()); //sized once, so building never rehashes
+        for (size_t elementIdx = 0; elementIdx < keys.size(); elementIdx++)
         {
-            throw ex; //propagate up the call stack
+            _insertOrAssign(pair_type(std::move(keys[elementIdx]), std::move(values[elementIdx])));
+        }
+    }
 
+    /**
+     * @brief Constructor for this class that accepts a range of pairs, moving them in when the
+     * range is of rvalues (for example through std::make_move_iterator). a key that appears more
+     * than once keeps its last value
+     * @param first the first pair of the range
+     * @param last the end of the range
+     */
+    template <typename InputIt,
+              typename = typename std::iterator_traits<InputIt>::iterator_category>
+    HashMap(InputIt first, InputIt last) : HashMap()
+    {
+        if (std::is_base_of<std::forward_iterator_tag,
+                            typename std::iterator_traits<InputIt>::iterator_category>::value)
+        {
+            reserve(std::distance(first, last));
         }
-        catch (std::bad_alloc &error)
+        for (; first != last; ++first)
         {
-            throw error; //move up call stack
+            _insertOrAssign(pair_type(*first));
         }
     }
 
+    /**
+     * @brief move constructor for this class. the moved from map is left empty
+     */
+    HashMap(HashMap &&other) noexcept : _size(other._size), _capacity(other._capacity),
+                                        _rehashCount(other._rehashCount),
+                                        _upperLoadFactor(other._upperLoadFactor),
+                                        _lowerLoadFactor(other._lowerLoadFactor),
+                                        _slots(other._slots), _probeLengths(other._probeLengths),
+                                        _hashes(other._hashes)
+    {
+        other._becomeEmpty();
+    }
+
     /**
      * @brief copy constructor for this class
      */
@@ -196,33 +566,37 @@ public:
     {
         _size = other._size;
         _capacity = other._capacity;
+        _rehashCount = other._rehashCount;
         _lowerLoadFactor = other._lowerLoadFactor;
         _upperLoadFactor = other._upperLoadFactor;
+        _allocateTable();
+        int slotIdx = 0;
         try
         {
-            this->_buckets = new std::vector<std::pair<KeyT, ValueT>>[_capacity];
-            for (int bucketIdx = 0; bucketIdx < capacity(); bucketIdx++)
+            for (; slotIdx < capacity(); slotIdx++)
             {
-                int currHashCode;
-                for (auto pair : other._buckets[bucketIdx])
+                if (other._probeLengths[slotIdx] != EMPTY_SLOT)
                 {
-                    currHashCode = _getHashCode(pair.first);
-                    _buckets[currHashCode].push_back(pair);
+                    //same capacity and hash, so every pair keeps its slot and its hash
+                    new(&_slots[slotIdx]) pair_type(other._slots[slotIdx]);
+                    _probeLengths[slotIdx] = other._probeLengths[slotIdx];
+                    _hashes[slotIdx] = other._hashes[slotIdx];
                 }
             }
         }
-        catch (std::bad_alloc &error)
+        catch (...)
         {
-            throw error; //propagate up call stack
+            _freeTable();
+            throw; //propagate up call stack
         }
     };
 
     /**
-     * @brief c'tor for this class
+     * @brief d'tor for this class
      */
     ~HashMap()
     {
-        delete[] _buckets;
+        _freeTable();
     }
 
     /**
@@ -264,17 +638,112 @@ public:
      */
     bool insert(const KeyT &key, const ValueT &value)
     {
-        if (containsKey(key))
+        size_t hash = _hash(key);
+        if (_findSlot(key, hash) != ERROR_CODE)
         {
             return false;
         }
-        int valHashCode = this->_getHashCode(key);
-        _size++;
-        this->_buckets[valHashCode].push_back(std::pair<KeyT, ValueT> (key, value));
-        this->_checkResize();
+        _insertNew(pair_type(key, value), hash);
+        return true;
+    };
+
+    /**
+     * @brief method to insert a pair into this class, moving the key and value in
+     * @param key the key of the pair
+     * @param value the value of the pair
+     */
+    bool insert(KeyT &&key, ValueT &&value)
+    {
+        size_t hash = _hash(key);
+        if (_findSlot(key, hash) != ERROR_CODE)
+        {
+            return false;
+        }
+        _insertNew(pair_type(std::move(key), std::move(value)), hash);
         return true;
     };
 
+    /**
+     * @brief constructs a pair in place and inserts it, unless its key is already in the table
+     * @param args the arguments to construct the pair from
+     * @return an iterator to the pair of the key, and true if the pair was inserted
+     */
+    template <typename... Args>
+    std::pair<hashMapIterator, bool> emplace(Args &&... args)
+    {
+        pair_type pair(std::forward<Args>(args)...);
+        size_t hash = _hash(pair.first);
+        int slotIdx = _findSlot(pair.first, hash);
+        bool inserted = slotIdx == ERROR_CODE;
+        if (inserted)
+        {
+            slotIdx = _insertNew(std::move(pair), hash);
+        }
+        return std::make_pair(hashMapIterator(_slots, _probeLengths, capacity(), slotIdx), inserted);
+    }
+
+    /**
+     * @brief inserts a key with a value constructed in place, unless the key is already in the
+     * table, in which case nothing is constructed or moved
+     * @param key the key of the pair
+     * @param args the arguments to construct the value from
+     * @return an iterator to the pair of the key, and true if the pair was inserted
+     */
+    template <typename... Args>
+    std::pair<hashMapIterator, bool> try_emplace(const KeyT &key, Args &&... args)
+    {
+        size_t hash = _hash(key);
+        int slotIdx = _findSlot(key, hash);
+        bool inserted = slotIdx == ERROR_CODE;
+        if (inserted)
+        {
+            slotIdx = _insertNew(pair_type(std::piecewise_construct, std::forward_as_tuple(key),
+                                           std::forward_as_tuple(std::forward<Args>(args)...)),
+                                 hash);
+        }
+        return std::make_pair(hashMapIterator(_slots, _probeLengths, capacity(), slotIdx), inserted);
+    }
+
+    /**
+     * @brief inserts a key with a value constructed in place, unless the key is already in the
+     * table, in which case nothing is constructed or moved
+     * @param key the key of the pair, moved in only if it's inserted
+     * @param args the arguments to construct the value from
+     * @return an iterator to the pair of the key, and true if the pair was inserted
+     */
+    template <typename... Args>
+    std::pair<hashMapIterator, bool> try_emplace(KeyT &&key, Args &&... args)
+    {
+        size_t hash = _hash(key);
+        int slotIdx = _findSlot(key, hash);
+        bool inserted = slotIdx == ERROR_CODE;
+        if (inserted)
+        {
+            slotIdx = _insertNew(pair_type(std::piecewise_construct,
+                                           std::forward_as_tuple(std::move(key)),
+                                           std::forward_as_tuple(std::forward<Args>(args)...)),
+                                 hash);
+        }
+        return std::make_pair(hashMapIterator(_slots, _probeLengths, capacity(), slotIdx), inserted);
+    }
+
+    /**
+     * @brief grows the table once so that it can hold a number of pairs without rehashing
+     * @param pairCount the number of pairs to make room for
+     */
+    void reserve(size_t pairCount)
+    {
+        int previousCapacity = capacity();
+        while ((double) pairCount / capacity() > _upperLoadFactor)
+        {
+            this->_capacity *= RESIZE_FACTOR;
+        }
+        if (capacity() != previousCapacity)
+        {
+            this->_rehash(previousCapacity);
+        }
+    }
+
     /**
      * @brief method to check if a key is contained in the table
      * @param key the key to check if it's contained
@@ -282,7 +751,43 @@ public:
      */
     bool containsKey(const KeyT &key) const
     {
-        return this->_getInnerKeyIdx(key) != ERROR_CODE;
+        return this->_findSlot(key) != ERROR_CODE;
+    }
+
+    /**
+     * @brief method to check if a string key is contained in the table, without building a string
+     * @param key the string view or c string to check if it's contained
+     * @return true if it's contained, false otherwise
+     */
+    template <typename LookupT, EnableTransparentLookup<KeyT, LookupT> = 0>
+    bool containsKey(const LookupT &key) const
+    {
+        return this->_findSlot(key) != ERROR_CODE;
+    }
+
+    /**
+     * @brief finds a key with a single probe of the table
+     * @param key the key to look for
+     * @return an iterator to the pair of the key, or end() if it's not in the table
+     */
+    hashMapIterator find(const KeyT &key) const
+    {
+        int slotIdx = _findSlot(key);
+        return slotIdx == ERROR_CODE ? end() : hashMapIterator(_slots, _probeLengths, capacity(),
+                                                               slotIdx);
+    }
+
+    /**
+     * @brief finds a string key with a single probe of the table, without building a string
+     * @param key the string view or c string to look for
+     * @return an iterator to the pair of the key, or end() if it's not in the table
+     */
+    template <typename LookupT, EnableTransparentLookup<KeyT, LookupT> = 0>
+    hashMapIterator find(const LookupT &key) const
+    {
+        int slotIdx = _findSlot(key);
+        return slotIdx == ERROR_CODE ? end() : hashMapIterator(_slots, _probeLengths, capacity(),
+                                                               slotIdx);
     }
 
     /**
@@ -292,15 +797,12 @@ public:
      */
     ValueT at(KeyT key) const
     {
-        if (containsKey(key))
-        {
-            return this->_buckets[_getHashCode(key)][_getInnerKeyIdx(key)].second;
-            //we take the value of the pair in relevant key outer and inner index
-        }
-        else
+        int slotIdx = _findSlot(key);
+        if (slotIdx == ERROR_CODE)
         {
             throw std::invalid_argument(NONEXISTANT_KEY_ERR);
         }
+        return _slots[slotIdx].second;
     };
 
     /**
@@ -310,15 +812,44 @@ public:
      */
     ValueT& at(KeyT key)
     {
-        if (containsKey(key))
+        int slotIdx = _findSlot(key);
+        if (slotIdx == ERROR_CODE)
         {
-            return this->_buckets[_getHashCode(key)][_getInnerKeyIdx(key)].second;
-            //we take the value of the pair in relevant key outer and inner index
+            throw std::invalid_argument(NONEXISTANT_KEY_ERR);
         }
-        else
+        return _slots[slotIdx].second;
+    };
+
+    /**
+     * @brief get the matching value for a string key, without building a string
+     * @param key the string view or c string of the value
+     * @return the value matching to the key
+     */
+    template <typename LookupT, EnableTransparentLookup<KeyT, LookupT> = 0>
+    ValueT at(const LookupT &key) const
+    {
+        int slotIdx = _findSlot(key);
+        if (slotIdx == ERROR_CODE)
+        {
+            throw std::invalid_argument(NONEXISTANT_KEY_ERR);
+        }
+        return _slots[slotIdx].second;
+    };
+
+    /**
+     * @brief get the matching value for a string key, without building a string
+     * @param key the string view or c string of the value
+     * @return the value matching to the key
+     */
+    template <typename LookupT, EnableTransparentLookup<KeyT, LookupT> = 0>
+    ValueT& at(const LookupT &key)
+    {
+        int slotIdx = _findSlot(key);
+        if (slotIdx == ERROR_CODE)
         {
             throw std::invalid_argument(NONEXISTANT_KEY_ERR);
         }
+        return _slots[slotIdx].second;
     };
 
     /**
@@ -328,23 +859,15 @@ public:
      */
     bool erase(KeyT key)
     {
-        try
-        {
-            if (containsKey(key))
-            {
-                std::vector<std::pair<KeyT, ValueT>> &keyVec = _buckets[bucketIndex(key)];
-                keyVec.erase(keyVec.begin() + this->_getInnerKeyIdx(key));
-                _size--;
-                _checkResize();
-                return true;
-            }
-        }
-        catch (std::invalid_argument &ex) //notice this error can only happen if the key isn't in
-            // the table
+        int slotIdx = _findSlot(key);
+        if (slotIdx == ERROR_CODE)
         {
             return false;
         }
-        return false;
+        _eraseSlot(slotIdx);
+        _size--;
+        _checkResize();
+        return true;
     };
 
     /**
@@ -357,60 +880,109 @@ public:
 
     /**
      * @param key that contains in the matching bucket
-     * @return the size of the bucket
+     * @return the number of pairs whose home slot is the home slot of the key
      */
     int bucketSize(KeyT key)
     {
-        if (containsKey(key))
-        {
-            return this->_buckets[_getHashCode(key)].size();
-        }
-        else
-        {
-            throw std::invalid_argument(NONEXISTANT_KEY_ERR);
-        }
+        return static_cast<const HashMap *>(this)->bucketSize(key);
     };
 
     /**
     * @param key that contains in the matching bucket
-    * @return the size of the bucket
+    * @return the number of pairs whose home slot is the home slot of the key
     */
     int bucketSize(KeyT key) const
     {
-        if (containsKey(key))
+        int slotIdx = _homeSlot(_hash(key));
+        int pairsInBucket = 0;
+        bool found = false;
+        //pairs sharing a home slot sit together, somewhere after it
+        for (uint32_t probeLength = 1; _probeLengths[slotIdx] >= probeLength; probeLength++)
         {
-            return this->_buckets[_getHashCode(key)].size();
+            if (_probeLengths[slotIdx] == probeLength)
+            {
+                pairsInBucket++;
+                found = found || _slots[slotIdx].first == key;
+            }
+            slotIdx = (slotIdx + 1) & (capacity() - 1);
         }
-        else
+        if (!found)
         {
             throw std::invalid_argument(NONEXISTANT_KEY_ERR);
         }
+        return pairsInBucket;
     };
 
     /**
      * @param key key to check the index for
-     * @return the index of the bucket
+     * @return the index of the home slot of the key
      */
     int bucketIndex(const KeyT &key) const
     {
-        if (containsKey(key))
-        {
-            return _getHashCode(key);
-        }
-        else
+        size_t hash = _hash(key);
+        if (_findSlot(key, hash) == ERROR_CODE)
         {
             throw std::invalid_argument(NONEXISTANT_KEY_ERR);
         }
+        return _homeSlot(hash);
     };
 
+    /**
+     * @brief walks the whole table, so it takes time linear in the capacity
+     * @return a snapshot of the layout of the table
+     */
+    HashMapStats stats() const
+    {
+        HashMapStats stats;
+        stats.size = size();
+        stats.capacity = capacity();
+        stats.loadFactor = getLoadFactor();
+        stats.rehashCount = _rehashCount;
+        stats.bytesAllocated = _slots == nullptr ? 0 : (sizeof(pair_type) + sizeof(uint32_t) +
+                                                        sizeof(size_t)) * capacity();
+        std::vector<int> homeSlotPairs(capacity(), 0);
+        long probeLengthSum = 0;
+        for (int slotIdx = 0; slotIdx < capacity(); slotIdx++)
+        {
+            if (_probeLengths[slotIdx] == EMPTY_SLOT)
+            {
+                continue;
+            }
+            int probeLength = (int) _probeLengths[slotIdx];
+            homeSlotPairs[(slotIdx - probeLength + 1) & (capacity() - 1)]++;
+            if ((int) stats.probeHistogram.size() < probeLength)
+            {
+                stats.probeHistogram.resize(probeLength, 0);
+            }
+            stats.probeHistogram[probeLength - 1]++;
+            stats.maxProbeLength = std::max(stats.maxProbeLength, probeLength);
+            stats.collisions += probeLength > 1;
+            probeLengthSum += probeLength;
+        }
+        for (int pairs : homeSlotPairs)
+        {
+            if ((int) stats.bucketHistogram.size() <= pairs)
+            {
+                stats.bucketHistogram.resize(pairs + 1, 0);
+            }
+            stats.bucketHistogram[pairs]++;
+        }
+        stats.averageProbeLength = size() == 0 ? 0 : (double) probeLengthSum / size();
+        return stats;
+    }
+
     /**
      * @brief clears the table of all pairs
      */
     void clear()
     {
-        for (int bucketIdx = 0; bucketIdx < capacity(); bucketIdx++)
+        for (int slotIdx = 0; slotIdx < capacity(); slotIdx++)
         {
-            _buckets[bucketIdx].clear();
+            if (_probeLengths[slotIdx] != EMPTY_SLOT)
+            {
+                _slots[slotIdx].~pair_type();
+                _probeLengths[slotIdx] = EMPTY_SLOT;
+            }
         }
         _size = 0;
     };
@@ -429,18 +1001,14 @@ public:
         typedef int difference_type;
         typedef std::forward_iterator_tag iterator_category;
 
-        hashMapIterator(std::vector<std::pair<KeyT, ValueT>> *bucketPtr, int mapSize, int bucketIdx
+        hashMapIterator(pair_type *slots, const uint32_t *probeLengths, int capacity, int slotIdx
                         = 0)
         {
-            _capacity = mapSize;
-            _bucketIdx = bucketIdx;
-            _bucketsPtr = bucketPtr;
-            currBucketIt = (*_bucketsPtr).begin();
-            if (bucketIdx == mapSize - 1)
-            {
-                currBucketIt = (bucketPtr[mapSize - 1]).end();
-            }
-            _updateCurrBucket();
+            _slots = slots;
+            _probeLengths = probeLengths;
+            _capacity = capacity;
+            _slotIdx = slotIdx;
+            _skipEmpty();
         }
 
         //oprators overload
@@ -450,22 +1018,22 @@ public:
          * @return true if map iterators are equal, false otherwise
          */
         bool operator==(const self_type &rhs) const
-        { return currBucketIt == rhs.currBucketIt; }
+        { return _slots == rhs._slots && _slotIdx == rhs._slotIdx; }
 
         /**
          * @brief overload for uneqaulity operator
          * @param other the other iterator to compare to
          * @return true if iterators are unequal, false otherwise
          */
-        bool operator!=(const self_type &rhs)
-        { return currBucketIt != rhs.currBucketIt; }
+        bool operator!=(const self_type &rhs) const
+        { return !(*this == rhs); }
 
         /**
          * @brief dereference oparator for this class
          * @return the relevant key pair value
          */
-        reference operator*()
-        { return *currBucketIt; }
+        reference operator*() const
+        { return _slots[_slotIdx]; }
 
         /**
          * @brief increment oparator for this class for ++<index name>
@@ -473,16 +1041,8 @@ public:
          */
         self_type &operator++()
         {
-            if (_bucketIdx == _capacity)
-            {
-                currBucketIt = _bucketsPtr[_capacity - 1].end();
-
-            }
-            if (currBucketIt != _bucketsPtr[_bucketIdx].end())
-            {
-                ++currBucketIt;
-            }
-            _updateCurrBucket();
+            _slotIdx++;
+            _skipEmpty();
             return *this;
         }
 
@@ -498,35 +1058,25 @@ public:
             return tempBucketIt;
         }
 
-        pointer operator->()
+        pointer operator->() const
         {
-            return &(*currBucketIt);
-        }
-
-        /**
-         * @brief overload for assigment operator
-         * @return the new iterator
-         */
-
-        hashMapIterator &operator = (hashMapIterator const &other)
-        {
-            _bucketsPtr = other._bucketsPtr;
-            _capacity = other._capacity;
-            _bucketIdx = other._bucketIdx;
-            currBucketIt(other.currBucketIt);
+            return &_slots[_slotIdx];
         }
 
     private:
-        std::vector<std::pair<KeyT, ValueT>> *_bucketsPtr;
+        pair_type *_slots;
+        const uint32_t *_probeLengths;
         int _capacity;
-        int _bucketIdx;
-        typename std::vector<std::pair<KeyT, ValueT>>::iterator currBucketIt;
-        void _updateCurrBucket()
+        int _slotIdx;
+
+        /**
+         * @brief moves the iterator forward to the next occupied slot, or to the end
+         */
+        void _skipEmpty()
         {
-            while (_bucketIdx < _capacity - 1 && currBucketIt == _bucketsPtr[_bucketIdx].end())
+            while (_slotIdx < _capacity && _probeLengths[_slotIdx] == EMPTY_SLOT)
             {
-                _bucketIdx++;
-                currBucketIt = (_bucketsPtr)[_bucketIdx].begin();
+                _slotIdx++;
             }
         }
     };
@@ -537,7 +1087,7 @@ public:
      */
     hashMapIterator begin() const
     {
-        return hashMapIterator(this->_buckets, capacity());
+        return hashMapIterator(this->_slots, this->_probeLengths, capacity());
     };
 
     /**
@@ -545,7 +1095,7 @@ public:
      */
     hashMapIterator end() const
     {
-        return hashMapIterator(this->_buckets, capacity(), capacity() - 1);
+        return hashMapIterator(this->_slots, this->_probeLengths, capacity(), capacity());
     };
 
     /**
@@ -574,33 +1124,9 @@ public:
     */
     bool operator == (const HashMap &other) const
     {
-        if(other.size() == _size)
-        {
-            for (int tempBucketIdx = 0; tempBucketIdx < _capacity; tempBucketIdx++)
-            {
-                for (auto element:_buckets[tempBucketIdx])
-                {
-                    if (!other.containsKey(element.first))
-                    {
-                        return false;
-                    }
-                }
-            }
-            return true;
-        }
-        return false;
-    };
-
-    /**
-    * @brief overload for equality operator
-    * @param other the other map to compare to
-    * @return true if maps are equal, false otherwise
-    */
-    bool operator == (const HashMap &other)
-    {
-        if (this->size() == other.size())
+        if (other.size() == _size)
         {
-            for (auto &element: (*this))
+            for (const auto &element : (*this))
             {
                 if (!other.containsKey(element.first))
                 {
@@ -622,16 +1148,6 @@ public:
         return !(*this == other);
     };
 
-    /**
-    * @brief overload for unequality operator
-    * @param other the other map to compare to
-    * @return true if maps are unequal, false otherwise
-    */
-    bool operator != (const HashMap &other)
-    {
-        return !(*this == other);
-    };
-
     /**
      * @brief overload for subscript operator
      * @param key the key to get the value for
@@ -639,11 +1155,13 @@ public:
      */
     ValueT &operator [] (const KeyT key)
     {
-        if (!this->containsKey(key))
+        size_t hash = _hash(key);
+        int slotIdx = _findSlot(key, hash);
+        if (slotIdx == ERROR_CODE)
         {
-            this->insert(key, ValueT());
+            slotIdx = _insertNew(pair_type(key, ValueT()), hash);
         }
-        return _buckets[_getHashCode(key)][_getInnerKeyIdx(key)].second;
+        return _slots[slotIdx].second;
     };
 
     /**
@@ -653,14 +1171,7 @@ public:
  */
     ValueT operator [] (const KeyT key) const
     {
-        if (this->containsKey(key))
-        {
-            return _buckets[_getHashCode(key)][_getInnerKeyIdx(key)].second;
-        }
-        else
-        {
-            throw std::invalid_argument(NONEXISTANT_KEY_ERR);
-        }
+        return at(key);
     };
 
     /**
@@ -670,16 +1181,26 @@ public:
      */
     HashMap &operator = (const HashMap &other)
     {
-        _capacity = other._capacity;
-        delete[] _buckets;
-        _buckets = new std::vector<std::pair<KeyT, ValueT>>[_capacity];
-        for (int bucketIdx = 0; bucketIdx < _capacity; bucketIdx++)
+        if (this != &other)
         {
-            for (auto &element: other._buckets[bucketIdx])
-            {
-                _buckets[bucketIdx] = other._buckets[bucketIdx];
-                this->_size++;
-            }
+            HashMap copy(other);
+            _swap(copy);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief move assigment operator =. the moved from map is left empty
+     * @param other the map to move into this map
+     * @return the new map
+     */
+    HashMap &operator = (HashMap &&other) noexcept
+    {
+        if (this != &other)
+        {
+            _freeTable();
+            _swap(other);
+            other._becomeEmpty();
         }
         return *this;
     }
@@ -0,0 +1,263 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <random>
+#include "HashMap.hpp"
+#include "TestCheck.hpp"
+
+const int RANDOM_OPERATIONS = 200000;
+const int RANDOM_KEY_RANGE = 5000;
+const unsigned RANDOM_SEED = 7;
+
+/**
+ * @brief hashes a number to itself, so tests know which keys share a home slot
+ */
+struct IdentityHash
+{
+    size_t operator()(int key) const
+    {
+        return (size_t) key;
+    }
+};
+
+/**
+ * @brief checks that a map holds exactly the pairs of a reference map, reached both by lookups
+ * and by iteration
+ * @param map the map to check
+ * @param model the pairs it should hold
+ * @param name the name of the check
+ */
+void checkSame(const HashMap<std::string, int> &map, const std::map<std::string, int> &model,
+               const std::string &name)
+{
+    bool same = map.size() == (int) model.size() && map.empty() == model.empty();
+    for (const auto &pair : model)
+    {
+        same = same && map.containsKey(pair.first) && map.at(pair.first) == pair.second;
+    }
+    int visited = 0;
+    for (const auto &pair : map)
+    {
+        auto modelPair = model.find(pair.first);
+        same = same && modelPair != model.end() && modelPair->second == pair.second;
+        visited++;
+    }
+    check(same && visited == (int) model.size(), name);
+}
+
+/**
+ * @brief insert, at and operator[], including keys that are already in the map
+ */
+void testInsertAndLookup()
+{
+    HashMap<std::string, int> map;
+    check(map.empty() && map.size() == 0 && map.capacity() == START_CAPACITY, "empty map");
+    check(map.insert("spam", 1), "insert new key");
+    check(!map.insert("spam", 2), "insert existing key fails");
+    check(map.at("spam") == 1, "insert existing key keeps value");
+    check(map.size() == 1, "insert existing key keeps size");
+    map.at("spam") = 3;
+    check(map.at(std::string("spam")) == 3, "at returns a reference");
+    check(map["ham"] == 0 && map.size() == 2, "operator[] inserts a default value");
+    map["ham"] = 4;
+    check(map["ham"] == 4 && map.size() == 2, "operator[] finds an existing key");
+    const HashMap<std::string, int> &constMap = map;
+    check(constMap["ham"] == 4 && constMap.at("ham") == 4, "const lookups");
+    checkThrows([&] { constMap.at("eggs"); }, "at of a missing key throws");
+    checkThrows([&] { map.at("eggs"); }, "non const at of a missing key throws");
+    checkThrows([&] { constMap["eggs"]; }, "const operator[] of a missing key throws");
+    check(!map.containsKey("eggs") && map.size() == 2, "failed lookups add nothing");
+    check(map.containsKey(std::string_view("spam")) && map.find("ham")->second == 4,
+          "lookups by string view and c string");
+}
+
+/**
+ * @brief the vector constructor, where a key given more than once keeps its last value
+ */
+void testVectorConstructor()
+{
+    HashMap<std::string, int> map({"a", "b", "a", "c", "b"}, {1, 2, 3, 4, 5});
+    check(map.size() == 3, "duplicate keys are counted once");
+    check(map.at("a") == 3 && map.at("b") == 5 && map.at("c") == 4,
+          "duplicate keys keep their last value");
+    checkThrows([] { HashMap<std::string, int>({"a", "b"}, {1}); },
+                "keys and values of different sizes throw");
+}
+
+/**
+ * @brief erase, down to an empty map and back
+ */
+void testErase()
+{
+    HashMap<int, int> map;
+    for (int key = 0; key < 100; key++)
+    {
+        map.insert(key, key * 2);
+    }
+    int grownCapacity = map.capacity();
+    check(grownCapacity > START_CAPACITY && map.getLoadFactor() <= DEFAULT_UPPER_LOAD_FACTOR,
+          "map grows past the upper load factor");
+    check(!map.erase(100), "erase of a missing key fails");
+    for (int key = 0; key < 100; key++)
+    {
+        check(map.erase(key), "erase of an existing key");
+        check(!map.containsKey(key), "erased key is gone");
+    }
+    check(map.empty() && map.size() == 0, "erasing every key empties the map");
+    check(map.capacity() >= MIN_CAPACITY && map.capacity() < grownCapacity,
+          "shrinking to empty keeps a capacity of at least one");
+    check(map.begin() == map.end(), "empty map has nothing to iterate");
+    checkThrows([&] { map.bucketIndex(0); }, "bucketIndex of a missing key throws");
+    for (int key = 0; key < 10; key++)
+    {
+        check(map.insert(key, key), "insert after shrinking to empty");
+    }
+    bool found = true;
+    for (int key = 0; key < 10; key++)
+    {
+        found = found && map.at(key) == key;
+    }
+    check(found && map.size() == 10, "lookups after shrinking to empty");
+    map.clear();
+    check(map.empty() && map.insert(1, 1) && map.at(1) == 1, "clear and reuse");
+}
+
+/**
+ * @brief bucketSize and bucketIndex count the pairs sharing a home slot, the way the buckets of
+ * the chained map did
+ */
+void testBuckets()
+{
+    HashMap<int, int, IdentityHash> map;
+    map.insert(1, 0);
+    map.insert(1 + START_CAPACITY, 0);
+    map.insert(1 + 2 * START_CAPACITY, 0);
+    map.insert(2, 0);
+    check(map.bucketIndex(1) == 1 && map.bucketIndex(1 + 2 * START_CAPACITY) == 1,
+          "colliding keys share a bucket index");
+    check(map.bucketSize(1 + START_CAPACITY) == 3, "bucketSize counts colliding keys");
+    check(map.bucketSize(2) == 1 && map.bucketIndex(2) == 2,
+          "a key displaced into by others keeps its own bucket");
+    map.erase(1);
+    check(map.bucketSize(1 + 2 * START_CAPACITY) == 2 && map.bucketSize(2) == 1,
+          "bucketSize after erase");
+    checkThrows([&] { map.bucketSize(1); }, "bucketSize of a missing key throws");
+    checkThrows([&] { map.bucketSize(1 + 3 * START_CAPACITY); },
+                "bucketSize of a missing key in a used bucket throws");
+
+    HashMap<std::string, int> strings;
+    for (int key = 0; key < 1000; key++)
+    {
+        strings.insert(std::to_string(key), key);
+    }
+    std::vector<bool> counted(strings.capacity(), false);
+    int bucketPairs = 0;
+    bool inRange = true;
+    for (const auto &pair : strings)
+    {
+        int bucket = strings.bucketIndex(pair.first);
+        inRange = inRange && bucket >= 0 && bucket < strings.capacity();
+        if (inRange && !counted[bucket])
+        {
+            counted[bucket] = true;
+            bucketPairs += strings.bucketSize(pair.first);
+        }
+    }
+    check(inRange && bucketPairs == strings.size(), "buckets hold every pair once");
+}
+
+/**
+ * @brief copying and assigning, including into a map that isn't empty
+ */
+void testCopyAndAssign()
+{
+    HashMap<std::string, int> map({"a", "b", "c"}, {1, 2, 3});
+    HashMap<std::string, int> copy(map);
+    copy["a"] = 10;
+    copy.erase("b");
+    check(map.size() == 3 && map.at("a") == 1 && map.containsKey("b"), "copies are independent");
+    check(copy.size() == 2 && copy.at("a") == 10, "copy changed on its own");
+
+    HashMap<std::string, int> assigned({"x", "y"}, {7, 8});
+    assigned = map;
+    check(assigned.size() == 3 && !assigned.containsKey("x") && assigned.at("c") == 3,
+          "assignment replaces the pairs");
+    assigned = map;
+    check(assigned.size() == 3, "assigning again doesn't add to the size");
+    const HashMap<std::string, int> &self = assigned;
+    assigned = self;
+    check(assigned.size() == 3 && assigned.at("b") == 2, "self assignment");
+    check(assigned == map && !(assigned != map), "assigned map equals its source");
+    assigned.erase("a");
+    check(assigned != map, "maps of different pairs differ");
+    HashMap<std::string, int> empty;
+    assigned = empty;
+    check(assigned.empty() && assigned.insert("z", 1), "assigning an empty map");
+
+    HashMap<std::string, int> moved(std::move(copy));
+    check(moved.size() == 2 && copy.empty() && copy.insert("a", 1), "moved from map is reusable");
+}
+
+/**
+ * @brief random inserts, erases and lookups against std::map, through growing and shrinking
+ */
+void testRandomOperations()
+{
+    std::mt19937 random(RANDOM_SEED);
+    std::uniform_int_distribution<int> keys(0, RANDOM_KEY_RANGE - 1);
+    std::uniform_int_distribution<int> operations(0, 3);
+    HashMap<std::string, int> map;
+    std::map<std::string, int> model;
+    bool same = true;
+    for (int operationIdx = 0; operationIdx < RANDOM_OPERATIONS; operationIdx++)
+    {
+        std::string key = std::to_string(keys(random));
+        //erases win over inserts in the second half, so the map shrinks back down
+        bool draining = operationIdx >= RANDOM_OPERATIONS / 2;
+        switch (operations(random))
+        {
+            case 0:
+                same = same && map.insert(key, operationIdx) ==
+                               model.emplace(key, operationIdx).second;
+                break;
+            case 1:
+                same = same && map.erase(key) == (model.erase(key) == 1);
+                break;
+            case 2:
+                if (draining)
+                {
+                    same = same && map.erase(key) == (model.erase(key) == 1);
+                }
+                else
+                {
+                    map[key] = operationIdx;
+                    model[key] = operationIdx;
+                }
+                break;
+            default:
+                same = same && map.containsKey(key) == (model.count(key) == 1);
+                break;
+        }
+        same = same && map.size() == (int) model.size();
+    }
+    check(same, "random operations match std::map");
+    checkSame(map, model, "pairs after random operations");
+    check(map.getLoadFactor() >= DEFAULT_LOWER_LOAD_FACTOR || map.capacity() == MIN_CAPACITY,
+          "map shrinks below the lower load factor");
+}
+
+/**
+ * @brief runs the tests of HashMap
+ * @return 0 if all checks passed, exit failure constant otherwise
+ */
+int main()
+{
+    testInsertAndLookup();
+    testVectorConstructor();
+    testErase();
+    testBuckets();
+    testCopyAndAssign();
+    testRandomOperations();
+    return checkResult();
+}
@@ -0,0 +1,49 @@
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "MappedFile.hpp"
+
+MappedFile::MappedFile(const std::string &filePath)
+{
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::invalid_argument(MAPPING_ERROR);
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+    {
+        close(fd);
+        throw std::invalid_argument(MAPPING_ERROR);
+    }
+    _size = (size_t) fileStat.st_size;
+    if (_size > 0) //an empty file can't be mapped, and has nothing to map anyway
+    {
+        void *mapping = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            close(fd);
+            throw std::invalid_argument(MAPPING_ERROR);
+        }
+        _data = static_cast<const char *>(mapping);
+    }
+    close(fd); //the mapping stays valid after the descriptor is closed
+}
+
+MappedFile::~MappedFile()
+{
+    if (_data != nullptr)
+    {
+        munmap(const_cast<char *>(_data), _size);
+    }
+}
+
+void MappedFile::adviseSequential() const
+{
+    if (_data != nullptr)
+    {
+        madvise(const_cast<char *>(_data), _size, MADV_SEQUENTIAL);
+    }
+}
@@ -0,0 +1,58 @@
+#include <string>
+#include <cstddef>
+
+#ifndef EX3_MAPPEDFILE_HPP
+#define EX3_MAPPEDFILE_HPP
+
+#define MAPPING_ERROR "Could not map file"
+
+/**
+ * @brief This class represents a read only memory mapping of a whole file
+ */
+class MappedFile
+{
+public:
+    /**
+     * @brief maps a file into memory
+     * @param filePath the path of the file
+     * @throw std::invalid_argument if the file can't be opened or mapped
+     */
+    explicit MappedFile(const std::string &filePath);
+
+    /**
+     * @brief d'tor for this class, unmaps the file
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile &other) = delete;
+
+    MappedFile &operator=(const MappedFile &other) = delete;
+
+    /**
+     * @brief tells the kernel the file will be read once from start to end, so it reads ahead
+     * more aggressively
+     */
+    void adviseSequential() const;
+
+    /**
+     * @return the first byte of the file, or null if the file is empty
+     */
+    const char *data() const
+    {
+        return _data;
+    }
+
+    /**
+     * @return the size of the file in bytes
+     */
+    size_t size() const
+    {
+        return _size;
+    }
+
+private:
+    const char *_data = nullptr;
+    size_t _size = 0;
+};
+
+#endif //EX3_MAPPEDFILE_HPP
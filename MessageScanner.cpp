@@ -0,0 +1,239 @@
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include "MessageScanner.hpp"
+#include "MappedFile.hpp"
+
+const long START_SCORE = 0;
+const char LINE_END = '\n';
+//chunks per thread, so threads that finish early take over the rest
+const size_t CHUNKS_PER_THREAD = 4;
+const size_t MIN_CHUNK_SIZE = 64 * 1024;
+
+namespace
+{
+    /**
+     * @brief scores text read line by line
+     * @tparam MatcherT the type of matcher, PhraseMatcher or TokenMatcher
+     * @param matcher the compiled map from words (or sentence to score)
+     * @param reader the stream to read the lines from
+     * @param scanState the scan state to use
+     * @param limit the score to stop at, if any
+     * @return the score of the text
+     */
+    template <typename MatcherT>
+    long scoreLines(const MatcherT &matcher, std::istream &reader,
+                    typename MatcherT::ScanState &scanState, PhraseMatcher::ScoreLimit *limit)
+    {
+        long message_score = START_SCORE;
+        std::string line;
+        while ((limit == nullptr || !limit->reached()) && std::getline(reader, line))
+        {
+            message_score += matcher.scoreText(line, scanState, limit);
+        }
+        return message_score;
+    }
+
+    /**
+     * @brief the fallback for messages that can't be mapped. streams them in chunks
+     * @param matcher the compiled map from words (or sentence to score)
+     * @param message the path of the message
+     * @param scanState the scan state to use
+     * @param limit the score to stop at, if any
+     * @return the score of the message, or the start score if it can't be opened
+     */
+    long scoreUnmapped(const PhraseMatcher &matcher, const std::string &message,
+                       PhraseMatcher::ScanState &scanState, PhraseMatcher::ScoreLimit *limit)
+    {
+        int fd = open(message.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return START_SCORE;
+        }
+        long score;
+        try
+        {
+            score = scoreStream(matcher, fd, scanState, limit);
+        }
+        catch (...)
+        {
+            close(fd);
+            throw;
+        }
+        close(fd);
+        return score;
+    }
+
+    /**
+     * @brief the fallback for messages that can't be mapped. reads them line by line
+     * @param matcher the matcher of the dictionary words
+     * @param message the path of the message
+     * @param scanState the scan state to use
+     * @param limit the score to stop at, if any
+     * @return the score of the message
+     */
+    long scoreUnmapped(const TokenMatcher &matcher, const std::string &message,
+                       TokenMatcher::ScanState &scanState, PhraseMatcher::ScoreLimit *limit)
+    {
+        std::ifstream fileReader(message);
+        return scoreLines(matcher, fileReader, scanState, limit);
+    }
+
+    /**
+     * @brief maps a message and scores it in place, or reads it line by line if it can't be
+     * mapped
+     * @tparam MatcherT the type of matcher, PhraseMatcher or TokenMatcher
+     * @param matcher the compiled map from words (or sentence to score)
+     * @param message the path of the message
+     * @param scanState the scan state to use for a message read by lines
+     * @param limit the score to stop at, if any
+     * @param scoreMapped scores the text of a mapped message
+     * @return the score of the message
+     */
+    template <typename MatcherT, typename ScoreMappedT>
+    long scoreMessageWith(const MatcherT &matcher, const std::string &message,
+                          typename MatcherT::ScanState &scanState,
+                          PhraseMatcher::ScoreLimit *limit, ScoreMappedT scoreMapped)
+    {
+        std::unique_ptr<MappedFile> mapping;
+        try
+        {
+            mapping.reset(new MappedFile(message));
+        }
+        catch (const std::invalid_argument &) //not a regular file, or can't be mapped
+        {
+            return scoreUnmapped(matcher, message, scanState, limit);
+        }
+        if (mapping->size() == 0) //some special files report no size but still have content
+        {
+            return scoreUnmapped(matcher, message, scanState, limit);
+        }
+        mapping->adviseSequential();
+        return scoreMapped(std::string_view(mapping->data(), mapping->size()));
+    }
+}
+
+ParallelScanner::ParallelScanner(const PhraseMatcher &matcher, WorkStealingPool &pool,
+                                 size_t cutoff) :
+        _matcher(matcher), _pool(pool), _cutoff(cutoff), _scanStates(pool.threadCount())
+{
+}
+
+PhraseMatcher::ScanState &ParallelScanner::scanState(size_t workerIdx)
+{
+    if (_scanStates[workerIdx] == nullptr)
+    {
+        _scanStates[workerIdx].reset(new PhraseMatcher::ScanState(_matcher));
+    }
+    return *_scanStates[workerIdx];
+}
+
+long ParallelScanner::scoreText(std::string_view text, PhraseMatcher::ScanState &callerState,
+                                PhraseMatcher::ScoreLimit *limit)
+{
+    size_t chunkCount = std::min(_pool.threadCount() * CHUNKS_PER_THREAD,
+                                 text.size() / MIN_CHUNK_SIZE);
+    if (text.size() < _cutoff || chunkCount < 2)
+    {
+        return _matcher.scoreText(text, callerState, limit);
+    }
+    //chunk ends are moved forward to the next line end, a chunk without one is merged
+    std::vector<size_t> chunkStarts(1, 0);
+    for (size_t chunkIdx = 1; chunkIdx < chunkCount; chunkIdx++)
+    {
+        size_t lineEnd = text.find(LINE_END, std::max(text.size() / chunkCount * chunkIdx,
+                                                      chunkStarts.back()));
+        if (lineEnd == std::string_view::npos || lineEnd + 1 == text.size())
+        {
+            break;
+        }
+        chunkStarts.push_back(lineEnd + 1);
+    }
+    chunkStarts.push_back(text.size());
+    std::vector<long> chunkScores(chunkStarts.size() - 1, START_SCORE);
+    _pool.parallelFor(chunkScores.size(), [&](size_t chunkIdx, size_t workerIdx)
+    {
+        PhraseMatcher::ScanState &state = workerIdx == NOT_A_WORKER ? callerState :
+                                          scanState(workerIdx);
+        std::string_view chunk = text.substr(chunkStarts[chunkIdx],
+                                             chunkStarts[chunkIdx + 1] - chunkStarts[chunkIdx]);
+        chunkScores[chunkIdx] = _matcher.scoreText(chunk, state, limit);
+    });
+    long textScore = START_SCORE;
+    for (long chunkScore : chunkScores)
+    {
+        textScore += chunkScore;
+    }
+    return textScore;
+}
+
+long scoreStream(const PhraseMatcher &matcher, int fd, PhraseMatcher::ScanState &scanState,
+                 PhraseMatcher::ScoreLimit *limit)
+{
+    std::unique_ptr<char[]> chunk(new char[STREAM_CHUNK_SIZE]);
+    long streamScore = START_SCORE;
+    while (limit == nullptr || !limit->reached())
+    {
+        ssize_t received = read(fd, chunk.get(), STREAM_CHUNK_SIZE);
+        if (received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (received < 0)
+        {
+            scanState.endStream();
+            throw std::runtime_error(STREAM_READ_ERROR);
+        }
+        if (received == 0)
+        {
+            break;
+        }
+        streamScore += matcher.scoreChunk(std::string_view(chunk.get(), (size_t) received),
+                                          scanState, limit);
+    }
+    scanState.endStream();
+    return streamScore;
+}
+
+long scoreMessage(const PhraseMatcher &matcher, const std::string &message,
+                  PhraseMatcher::ScanState &scanState, PhraseMatcher::ScoreLimit *limit,
+                  ParallelScanner *parallel)
+{
+    if (message == STDIN_MESSAGE_PATH)
+    {
+        return scoreStream(matcher, STDIN_FILENO, scanState, limit);
+    }
+    return scoreMessageWith(matcher, message, scanState, limit, [&](std::string_view text)
+    {
+        if (parallel != nullptr)
+        {
+            return parallel->scoreText(text, scanState, limit);
+        }
+        return matcher.scoreText(text, scanState, limit);
+    });
+}
+
+long scoreMessage(const TokenMatcher &matcher, const std::string &message,
+                  TokenMatcher::ScanState &scanState, PhraseMatcher::ScoreLimit *limit)
+{
+    if (message == STDIN_MESSAGE_PATH)
+    {
+        return scoreLines(matcher, std::cin, scanState, limit);
+    }
+    return scoreMessageWith(matcher, message, scanState, limit, [&](std::string_view text)
+    {
+        return matcher.scoreText(text, scanState, limit);
+    });
+}
+
+bool isSpam(const PhraseMatcher &matcher, std::string message, int threshold)
+{
+    PhraseMatcher::ScanState scanState(matcher);
+    PhraseMatcher::ScoreLimit limit(threshold);
+    return scoreMessage(matcher, message, scanState, &limit) >= threshold;
+}
@@ -0,0 +1,129 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include "PhraseMatcher.hpp"
+#include "TokenMatcher.hpp"
+#include "WorkStealingPool.hpp"
+
+#ifndef EX3_MESSAGESCANNER_HPP
+#define EX3_MESSAGESCANNER_HPP
+
+#define STREAM_READ_ERROR "Could not read message"
+//the message path that names the standard input
+#define STDIN_MESSAGE_PATH "-"
+
+const size_t DEFAULT_PARALLEL_CUTOFF = 1 << 20;
+//streams are read and scanned this many bytes at a time, whatever their size
+const size_t STREAM_CHUNK_SIZE = 64 * 1024;
+
+/**
+ * @brief This class splits large messages into chunks of whole lines and scans them on the
+ * workers of a pool. matching starts over at every line, so the chunks are independent and their
+ * scores add up to exactly the score of a serial scan. every worker gets its own scan state the
+ * first time it scans a chunk
+ */
+class ParallelScanner
+{
+public:
+    /**
+     * @brief constructor for this class
+     * @param matcher the matcher to scan with
+     * @param pool the pool to scan on
+     * @param cutoff the size from which a text is split
+     */
+    ParallelScanner(const PhraseMatcher &matcher, WorkStealingPool &pool, size_t cutoff);
+
+    /**
+     * @brief getter method for the scan state of a worker, created on first use. only the worker
+     * itself may use it
+     * @param workerIdx the index of the worker
+     * @return the scan state of the worker
+     */
+    PhraseMatcher::ScanState &scanState(size_t workerIdx);
+
+    /**
+     * @return the scan states of the workers, null for workers that didn't scan yet
+     */
+    const std::vector<std::unique_ptr<PhraseMatcher::ScanState>> &scanStates() const
+    {
+        return _scanStates;
+    }
+
+    /**
+     * @brief scores a text, split between the calling thread and the workers if it's at least
+     * the cutoff size. the result is the same as PhraseMatcher::scoreText
+     * @param text the text to score, any number of whole lines
+     * @param callerState the scan state of the calling thread, used when it isn't a worker
+     * @param limit the score to stop at, if any. it's shared by all chunks, so a chunk that
+     * reaches it stops the others
+     * @return the score of the text
+     */
+    long scoreText(std::string_view text, PhraseMatcher::ScanState &callerState,
+                   PhraseMatcher::ScoreLimit *limit);
+
+private:
+    const PhraseMatcher &_matcher;
+    WorkStealingPool &_pool;
+    size_t _cutoff;
+    std::vector<std::unique_ptr<PhraseMatcher::ScanState>> _scanStates;
+};
+
+/**
+ * @brief sums the scores of all phrases found in a stream, read from a file descriptor in chunks
+ * of a fixed size. the matcher carries on across chunk ends, so memory use doesn't depend on the
+ * size of the stream or its lines, and the score is the same as scanning it whole
+ * @param matcher the compiled map from words (or sentence to score)
+ * @param fd the descriptor to read from, it's read to its end but not closed
+ * @param scanState the scan state to use, may be reused between messages
+ * @param limit if given, reading stops as soon as the message reaches its threshold, and the
+ * score returned is only known to be at least the threshold
+ * @return the score of the stream
+ * @throw std::runtime_error if reading fails
+ */
+long scoreStream(const PhraseMatcher &matcher, int fd, PhraseMatcher::ScanState &scanState,
+                 PhraseMatcher::ScoreLimit *limit = nullptr);
+
+/**
+ * @brief sums the scores of all phrases found in a message. a regular file is mapped and scanned
+ * in place, without copying it into lines. pipes, devices and other inputs that can't be mapped
+ * are streamed instead, with the same result
+ * @param matcher the compiled map from words (or sentence to score)
+ * @param message the path of the message to be checked, or the stdin path constant to stream the
+ * standard input
+ * @param scanState the scan state to use, may be reused between messages
+ * @param limit if given, scanning stops as soon as the message reaches its threshold, and the
+ * score returned is only known to be at least the threshold
+ * @param parallel if given, a mapped message is scanned with it, so a large one is split
+ * @return the score of the message
+ */
+long scoreMessage(const PhraseMatcher &matcher, const std::string &message,
+                  PhraseMatcher::ScanState &scanState, PhraseMatcher::ScoreLimit *limit = nullptr,
+                  ParallelScanner *parallel = nullptr);
+
+/**
+ * @brief sums the scores of all phrases found in a message by whole words. mapped the same way
+ * as with a PhraseMatcher, but never split between threads, and read line by line if it can't be
+ * mapped
+ * @param matcher the matcher of the dictionary words
+ * @param message the path of the message to be checked, or the stdin path constant to read the
+ * standard input
+ * @param scanState the scan state to use, may be reused between messages
+ * @param limit if given, scanning stops as soon as the message reaches its threshold, and the
+ * score returned is only known to be at least the threshold
+ * @return the score of the message
+ */
+long scoreMessage(const TokenMatcher &matcher, const std::string &message,
+                  TokenMatcher::ScanState &scanState, PhraseMatcher::ScoreLimit *limit = nullptr);
+
+/**
+ * @brief checks if a message is spam or not. the message is only scanned up to the point where
+ * it reaches the threshold
+ * @param matcher the compiled map from words (or sentence to score)
+ * @param message the message to be checked
+ * @param the threshold for if a message is a spam or not
+ * @return true if spam, false otherwise
+ */
+bool isSpam(const PhraseMatcher &matcher, std::string message, int threshold);
+
+#endif //EX3_MESSAGESCANNER_HPP
@@ -0,0 +1,242 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <random>
+#include <thread>
+#include <algorithm>
+#include <csignal>
+#include <unistd.h>
+#include "HashMap.hpp"
+#include "PhraseMatcher.hpp"
+#include "WorkStealingPool.hpp"
+#include "MessageScanner.hpp"
+#include "TestCheck.hpp"
+
+const size_t TEST_THREADS = 4;
+//far below the default, so every test message is split
+const size_t TEST_PARALLEL_CUTOFF = 1024;
+//enough bytes for the most chunks the scanner splits into
+const size_t LARGE_MESSAGE_SIZE = 2 * 1024 * 1024;
+const size_t MAX_LINE_WORDS = 40;
+const unsigned RANDOM_SEED = 13;
+const size_t MAX_WRITE_SIZE = 3 * STREAM_CHUNK_SIZE / 2;
+const std::vector<std::string> TEST_PHRASES = {"spam", "free money", "aa", "win", "money"};
+const std::vector<std::string> TEST_WORDS = {"spam", "free", "money", "aaa", "a", "win",
+                                             "WIN", "Free", "hello", "world"};
+
+/**
+ * @return a matcher over the test phrases, scored by their index plus one
+ */
+PhraseMatcher makeMatcher()
+{
+    HashMap<std::string_view, int> scoreMap;
+    for (size_t phraseIdx = 0; phraseIdx < TEST_PHRASES.size(); phraseIdx++)
+    {
+        scoreMap.insert(TEST_PHRASES[phraseIdx], (int) phraseIdx + 1);
+    }
+    return PhraseMatcher(scoreMap);
+}
+
+/**
+ * @param random the random generator
+ * @param size the size to reach
+ * @return a message of random lines of the test words, of at least the size
+ */
+std::string makeMessage(std::mt19937 &random, size_t size)
+{
+    std::uniform_int_distribution<size_t> word(0, TEST_WORDS.size() - 1);
+    std::uniform_int_distribution<size_t> lineWords(0, MAX_LINE_WORDS);
+    std::string message;
+    while (message.size() < size)
+    {
+        for (size_t wordIdx = lineWords(random); wordIdx > 0; wordIdx--)
+        {
+            message += TEST_WORDS[word(random)];
+            message += ' ';
+        }
+        message += '\n';
+    }
+    return message;
+}
+
+/**
+ * @param caller the scan state of the calling thread
+ * @param parallel the scanner whose worker states to add
+ * @return the bytes scanned with all the states
+ */
+uint64_t bytesScanned(const PhraseMatcher::ScanState &caller, const ParallelScanner &parallel)
+{
+    uint64_t bytes = caller.bytesScanned();
+    for (const auto &state : parallel.scanStates())
+    {
+        bytes += state == nullptr ? 0 : state->bytesScanned();
+    }
+    return bytes;
+}
+
+/**
+ * @brief a message split into chunks over the workers scores the same as a serial scan, and
+ * every byte is scanned once
+ */
+void testFullScore(const PhraseMatcher &matcher, WorkStealingPool &pool)
+{
+    std::mt19937 random(RANDOM_SEED);
+    ParallelScanner parallel(matcher, pool, TEST_PARALLEL_CUTOFF);
+    PhraseMatcher::ScanState callerState(matcher);
+    PhraseMatcher::ScanState serialState(matcher);
+    std::vector<std::string> messages = {makeMessage(random, LARGE_MESSAGE_SIZE),
+                                         makeMessage(random, LARGE_MESSAGE_SIZE / 3),
+                                         std::string(LARGE_MESSAGE_SIZE, 'a'),
+                                         std::string(LARGE_MESSAGE_SIZE / 2, 'a') + "\n" +
+                                         std::string(LARGE_MESSAGE_SIZE / 2, 'a'),
+                                         "spam\nfree money\n"};
+    //a last line without a newline
+    messages.push_back(messages[0] + "free money");
+    for (const auto &message : messages)
+    {
+        uint64_t bytesBefore = bytesScanned(callerState, parallel);
+        long parallelScore = parallel.scoreText(message, callerState, nullptr);
+        check(parallelScore == matcher.scoreText(message, serialState),
+              "a split message scores the same as a serial scan, size " +
+              std::to_string(message.size()));
+        check(bytesScanned(callerState, parallel) - bytesBefore == message.size(),
+              "every byte of a split message is scanned once");
+    }
+}
+
+/**
+ * @brief with a limit, a split message gets the verdict of a serial scan, and chunks stop once
+ * the message reaches its threshold, including chunks another thread is scanning
+ */
+void testVerdict(const PhraseMatcher &matcher, WorkStealingPool &pool)
+{
+    std::mt19937 random(RANDOM_SEED + 1);
+    std::string message = makeMessage(random, LARGE_MESSAGE_SIZE);
+    PhraseMatcher::ScanState serialState(matcher);
+    long fullScore = matcher.scoreText(message, serialState);
+    std::vector<long> thresholds = {1, fullScore / 100, fullScore / 2, fullScore - 1, fullScore,
+                                    fullScore + 1, fullScore * 2};
+    for (long threshold : thresholds)
+    {
+        ParallelScanner parallel(matcher, pool, TEST_PARALLEL_CUTOFF);
+        PhraseMatcher::ScanState callerState(matcher);
+        PhraseMatcher::ScoreLimit limit(threshold);
+        long score = parallel.scoreText(message, callerState, &limit);
+        std::string name = " at threshold " + std::to_string(threshold);
+        check((score >= threshold) == (fullScore >= threshold),
+              "a split message gets the serial verdict" + name);
+        check(limit.reached() == (fullScore >= threshold), "the limit is reached" + name);
+        uint64_t bytes = bytesScanned(callerState, parallel);
+        if (fullScore >= threshold)
+        {
+            check(score <= fullScore, "a stopped scan counts no more than a full one" + name);
+        }
+        else
+        {
+            check(score == fullScore && bytes == message.size(),
+                  "a scan that never reaches its threshold reads everything" + name);
+        }
+        if (threshold <= fullScore / 2)
+        {
+            check(bytes < message.size(), "chunks stop once the threshold is reached" + name);
+        }
+    }
+}
+
+/**
+ * @brief streams a message through a pipe, written in pieces of random sizes so reads end at
+ * arbitrary points, and scores it
+ * @param matcher the matcher
+ * @param message the message
+ * @param state the scan state of the stream
+ * @param limit the score to stop at, if any
+ * @param seed the seed of the piece sizes
+ * @return the score of the stream
+ */
+long scorePiped(const PhraseMatcher &matcher, const std::string &message,
+                PhraseMatcher::ScanState &state, PhraseMatcher::ScoreLimit *limit, unsigned seed)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        check(false, "a pipe to stream through");
+        return -1;
+    }
+    std::thread writer([&message, fd = fds[1], seed]
+    {
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<size_t> pieceSize(1, MAX_WRITE_SIZE);
+        size_t written = 0;
+        while (written < message.size())
+        {
+            size_t piece = std::min(pieceSize(random), message.size() - written);
+            ssize_t sent = write(fd, message.data() + written, piece);
+            if (sent <= 0) //a stream stopped by its limit closes the pipe early
+            {
+                break;
+            }
+            written += (size_t) sent;
+        }
+        close(fd);
+    });
+    long score = scoreStream(matcher, fds[0], state, limit);
+    close(fds[0]);
+    writer.join();
+    return score;
+}
+
+/**
+ * @brief a message read from a descriptor in chunks scores the same as scanning it whole, with
+ * phrases cut by the chunk size and by short reads
+ */
+void testStream(const PhraseMatcher &matcher)
+{
+    std::mt19937 random(RANDOM_SEED + 2);
+    std::string message = makeMessage(random, 3 * STREAM_CHUNK_SIZE);
+    //phrases across the ends of the chunks a full read gives
+    for (size_t chunkEnd = STREAM_CHUNK_SIZE; chunkEnd < message.size();
+         chunkEnd += STREAM_CHUNK_SIZE)
+    {
+        message.replace(chunkEnd - 5, 10, "free money");
+    }
+    std::vector<std::string> messages = {message, std::string(3 * STREAM_CHUNK_SIZE + 1, 'a'),
+                                         "free money", ""};
+    PhraseMatcher::ScanState wholeState(matcher);
+    PhraseMatcher::ScanState streamState(matcher);
+    for (size_t messageIdx = 0; messageIdx < messages.size(); messageIdx++)
+    {
+        const std::string &text = messages[messageIdx];
+        std::string name = ", size " + std::to_string(text.size());
+        uint64_t wholeLines = wholeState.linesScanned();
+        uint64_t streamLines = streamState.linesScanned();
+        long whole = matcher.scoreText(text, wholeState);
+        check(scorePiped(matcher, text, streamState, nullptr, RANDOM_SEED + messageIdx) == whole,
+              "a streamed message scores the same as a whole one" + name);
+        check(streamState.linesScanned() - streamLines == wholeState.linesScanned() - wholeLines,
+              "a streamed message counts the lines of a whole one" + name);
+        for (long threshold : {1L, whole / 2, whole + 1})
+        {
+            PhraseMatcher::ScoreLimit limit(threshold);
+            long score = scorePiped(matcher, text, streamState, &limit, RANDOM_SEED);
+            check((score >= threshold) == (whole >= threshold),
+                  "a streamed message gets the verdict of a whole one" + name);
+        }
+    }
+}
+
+/**
+ * @brief runs the tests of ParallelScanner and scoreStream
+ * @return 0 if all checks passed, exit failure constant otherwise
+ */
+int main()
+{
+    PhraseMatcher matcher = makeMatcher();
+    WorkStealingPool pool(TEST_THREADS);
+    testFullScore(matcher, pool);
+    testVerdict(matcher, pool);
+    //a stream stopped by its limit closes the pipe before its writer is done
+    signal(SIGPIPE, SIG_IGN);
+    testStream(matcher);
+    return checkResult();
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include "MessageSource.hpp"
+
+MessageSource::MessageSource(std::vector<std::string> inputs) : _inputs(std::move(inputs))
+{
+}
+
+bool MessageSource::inputsExist() const
+{
+    for (const auto &input : _inputs)
+    {
+        if (input == STDIN_MANIFEST)
+        {
+            continue;
+        }
+        std::string path = !input.empty() && input[0] == MANIFEST_PREFIX ? input.substr(1) : input;
+        if (!boost::filesystem::exists(path))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MessageSource::next(std::string &messagePath)
+{
+    while (true)
+    {
+        if (_manifest != nullptr)
+        {
+            if (std::getline(*_manifest, messagePath))
+            {
+                if (!messagePath.empty())
+                {
+                    return true;
+                }
+                continue;
+            }
+            _manifest = nullptr;
+            _manifestFile.reset();
+        }
+        if (_entryIdx < _directoryEntries.size())
+        {
+            messagePath = _directoryEntries[_entryIdx++];
+            return true;
+        }
+        if (_inputIdx == _inputs.size())
+        {
+            return false;
+        }
+        const std::string &input = _inputs[_inputIdx++];
+        if (input == STDIN_MANIFEST)
+        {
+            _manifest = &std::cin;
+        }
+        else if (!input.empty() && input[0] == MANIFEST_PREFIX)
+        {
+            _manifestFile.reset(new std::ifstream(input.substr(1)));
+            _manifest = _manifestFile.get();
+        }
+        else if (boost::filesystem::is_directory(input))
+        {
+            _directoryEntries.clear();
+            _entryIdx = 0;
+            for (const auto &entry : boost::filesystem::directory_iterator(input))
+            {
+                if (boost::filesystem::is_regular_file(entry.status()))
+                {
+                    _directoryEntries.push_back(entry.path().string());
+                }
+            }
+            std::sort(_directoryEntries.begin(), _directoryEntries.end());
+        }
+        else
+        {
+            messagePath = input;
+            return true;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <memory>
+
+#ifndef EX3_MESSAGESOURCE_HPP
+#define EX3_MESSAGESOURCE_HPP
+
+#define MANIFEST_PREFIX '@'
+#define STDIN_MANIFEST "@-"
+
+/**
+ * @brief This class represents the list of messages of a batch run. every input is either a
+ * message path, a directory (all of its regular files, sorted by name) or a manifest file written
+ * as @<path> holding one message path per line (@- reads the manifest from the standard input).
+ * inputs are expanded one at a time, as the paths before them are used up. a manifest is read a
+ * line at a time, so it may list any number of messages. a directory is listed whole to sort it,
+ * so the paths of one directory are held in memory until they are used up
+ */
+class MessageSource
+{
+public:
+    /**
+     * @brief constructor for this class
+     * @param inputs the message paths, directories and manifests, in order
+     */
+    explicit MessageSource(std::vector<std::string> inputs);
+
+    /**
+     * @brief checks that every input exists, without reading the messages themselves
+     * @return true if all inputs exist, false otherwise
+     */
+    bool inputsExist() const;
+
+    /**
+     * @brief getter method for the next message path
+     * @param messagePath the string to store the path in
+     * @return true if a path was read, false if there are no more messages
+     */
+    bool next(std::string &messagePath);
+
+private:
+    std::vector<std::string> _inputs;
+    size_t _inputIdx = 0;
+    //the sorted paths of the directory being expanded
+    std::vector<std::string> _directoryEntries;
+    size_t _entryIdx = 0;
+    std::unique_ptr<std::ifstream> _manifestFile;
+    std::istream *_manifest = nullptr;
+};
+
+#endif //EX3_MESSAGESOURCE_HPP
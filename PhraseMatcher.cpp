@@ -0,0 +1,317 @@
+#include <algorithm>
+#include <queue>
+#include <climits>
+#include "PhraseMatcher.hpp"
+#include "CaseFold.hpp"
+
+const uint32_t ROOT_STATE = 0;
+const uint32_t NO_STATE = UINT32_MAX;
+const int ALPHABET_SIZE = 256;
+const char LINE_END = '\n';
+//text is lower cased a block at a time into a buffer that stays in the l1 cache
+const size_t FOLD_BLOCK_SIZE = 4096;
+
+namespace
+{
+    /**
+     * @brief the phrases below a trie state, a range of the sorted phrases that share the first
+     * depth bytes
+     */
+    struct PhraseRange
+    {
+        size_t first;
+        size_t last;
+        size_t depth;
+    };
+
+    /**
+     * @param bits the bits
+     * @param index the index of a bit
+     * @return true if the bit is set, false otherwise
+     */
+    bool testBit(const uint64_t *bits, uint32_t index)
+    {
+        return (bits[index / BITS_IN_WORD] >> (index % BITS_IN_WORD)) & 1;
+    }
+
+    /**
+     * @param bits the bits
+     * @param rank the number of bits set before every word
+     * @param index the index of a bit
+     * @return the number of bits set before that bit
+     */
+    uint32_t rankBit(const uint64_t *bits, const uint32_t *rank, uint32_t index)
+    {
+        uint64_t below = bits[index / BITS_IN_WORD] & ((1ULL << (index % BITS_IN_WORD)) - 1);
+        return rank[index / BITS_IN_WORD] + (uint32_t) __builtin_popcountll(below);
+    }
+
+    /**
+     * @param bits the bits
+     * @return the number of bits set before every word
+     */
+    std::vector<uint32_t> rankWords(const std::vector<uint64_t> &bits)
+    {
+        std::vector<uint32_t> rank;
+        rank.reserve(bits.size());
+        uint32_t setBits = 0;
+        for (uint64_t word : bits)
+        {
+            rank.push_back(setBits);
+            setBits += (uint32_t) __builtin_popcountll(word);
+        }
+        return rank;
+    }
+}
+
+PhraseMatcher::ScanState::ScanState(const PhraseMatcher &matcher) :
+        _nextAllowed(matcher.phraseCount(), 0), _offset(0), _lineCount(0), _matchCount(0),
+        _current(ROOT_STATE), _lineOpen(false)
+{
+}
+
+void PhraseMatcher::ScanState::endStream()
+{
+    if (_lineOpen)
+    {
+        _lineCount++;
+        _lineOpen = false;
+    }
+    _current = ROOT_STATE;
+}
+
+PhraseMatcher::PhraseMatcher(const HashMap<std::string_view, int> &scoreMap)
+{
+    //sorted, the phrases below every state of the trie are a range that starts with the phrase
+    //ending at the state, if any, followed by the ranges of its children in label order
+    std::vector<std::pair<std::string_view, int>> phrases;
+    phrases.reserve(scoreMap.size());
+    for (const auto &pair : scoreMap)
+    {
+        if (!pair.first.empty()) //an empty phrase never advances the scan, so it's never counted
+        {
+            phrases.emplace_back(pair.first, pair.second);
+        }
+    }
+    std::sort(phrases.begin(), phrases.end());
+
+    //lay the trie out breadth first, so the children of a state are numbered after all the
+    //states before it and the target of every edge is the state after it
+    std::queue<PhraseRange> pending;
+    pending.push({0, phrases.size(), 0});
+    while (!pending.empty())
+    {
+        PhraseRange range = pending.front();
+        pending.pop();
+        size_t state = _edgeStart.size();
+        if (state % BITS_IN_WORD == 0)
+        {
+            _terminalBits.push_back(0);
+        }
+        _edgeStart.push_back((uint32_t) _edgeLabel.size());
+        size_t first = range.first;
+        if (first < range.last && phrases[first].first.size() == range.depth)
+        {
+            _terminalBits.back() |= 1ULL << (state % BITS_IN_WORD);
+            _phraseLength.push_back((uint32_t) range.depth);
+            _phraseScore.push_back(phrases[first].second);
+            first++;
+        }
+        while (first < range.last)
+        {
+            unsigned char label = (unsigned char) phrases[first].first[range.depth];
+            size_t last = first + 1;
+            while (last < range.last && (unsigned char) phrases[last].first[range.depth] == label)
+            {
+                last++;
+            }
+            _edgeLabel.push_back(label);
+            pending.push({first, last, range.depth + 1});
+            first = last;
+        }
+    }
+    _edgeStart.push_back((uint32_t) _edgeLabel.size());
+    _rootNext.assign(ALPHABET_SIZE, ROOT_STATE);
+    for (uint32_t edge = _edgeStart[ROOT_STATE]; edge < _edgeStart[ROOT_STATE + 1]; edge++)
+    {
+        _rootNext[_edgeLabel[edge]] = edge + 1;
+    }
+
+    //in breadth first order the failure link of a state always points back to a state whose
+    //links are already set, so the states are simply visited in order
+    size_t stateCount = _edgeStart.size() - 1;
+    std::vector<uint32_t> outputLinks(stateCount, NO_STATE); //compacted to bits once complete
+    _fail.assign(stateCount, ROOT_STATE);
+    _useOwnedStorage();
+    for (uint32_t state = ROOT_STATE + 1; state < stateCount; state++)
+    {
+        for (uint32_t edge = _edgeStart[state]; edge < _edgeStart[state + 1]; edge++)
+        {
+            uint32_t fallback = _step(_fail[state], _edgeLabel[edge]);
+            _fail[edge + 1] = fallback;
+            outputLinks[edge + 1] = testBit(_terminalBits.data(), fallback) ? fallback :
+                                    outputLinks[fallback];
+        }
+    }
+    _outputBits.assign(_terminalBits.size(), 0);
+    for (uint32_t state = ROOT_STATE; state < stateCount; state++)
+    {
+        if (outputLinks[state] != NO_STATE)
+        {
+            _outputBits[state / BITS_IN_WORD] |= 1ULL << (state % BITS_IN_WORD);
+            _outputLink.push_back(outputLinks[state]);
+        }
+    }
+    _terminalRank = rankWords(_terminalBits);
+    _outputRank = rankWords(_outputBits);
+    _useOwnedStorage();
+}
+
+PhraseMatcher::PhraseMatcher(const Tables &tables, std::shared_ptr<const void> owner) :
+        _tables(tables), _owner(std::move(owner))
+{
+}
+
+void PhraseMatcher::_useOwnedStorage()
+{
+    _tables.stateCount = _fail.size();
+    _tables.phraseCount = _phraseLength.size();
+    _tables.outputLinkCount = _outputLink.size();
+    _tables.edgeStart = _edgeStart.data();
+    _tables.edgeLabel = _edgeLabel.data();
+    _tables.rootNext = _rootNext.data();
+    _tables.fail = _fail.data();
+    _tables.terminalBits = _terminalBits.data();
+    _tables.terminalRank = _terminalRank.data();
+    _tables.outputBits = _outputBits.data();
+    _tables.outputRank = _outputRank.data();
+    _tables.outputLink = _outputLink.data();
+    _tables.phraseLength = _phraseLength.data();
+    _tables.phraseScore = _phraseScore.data();
+}
+
+uint32_t PhraseMatcher::_child(uint32_t state, unsigned char label) const
+{
+    const unsigned char *first = _tables.edgeLabel + _tables.edgeStart[state];
+    const unsigned char *last = _tables.edgeLabel + _tables.edgeStart[state + 1];
+    const unsigned char *found = std::lower_bound(first, last, label);
+    if (found == last || *found != label)
+    {
+        return NO_STATE;
+    }
+    return (uint32_t) (found - _tables.edgeLabel) + 1;
+}
+
+uint32_t PhraseMatcher::_step(uint32_t state, unsigned char label) const
+{
+    while (state != ROOT_STATE)
+    {
+        uint32_t next = _child(state, label);
+        if (next != NO_STATE)
+        {
+            return next;
+        }
+        state = _tables.fail[state];
+    }
+    return _tables.rootNext[label];
+}
+
+uint32_t PhraseMatcher::_outputLinkOf(uint32_t state) const
+{
+    if (!testBit(_tables.outputBits, state))
+    {
+        return NO_STATE;
+    }
+    return _tables.outputLink[rankBit(_tables.outputBits, _tables.outputRank, state)];
+}
+
+long PhraseMatcher::scoreText(std::string_view text, ScanState &state, ScoreLimit *limit) const
+{
+    state.endStream();
+    uint64_t startOffset = state._offset;
+    long textScore = _scan(text, state, limit);
+    size_t scanned = state._offset - startOffset;
+    if (scanned > 0 && text[scanned - 1] != LINE_END)
+    {
+        state._lineCount++;
+    }
+    state._current = ROOT_STATE;
+    return textScore;
+}
+
+long PhraseMatcher::scoreChunk(std::string_view chunk, ScanState &state, ScoreLimit *limit) const
+{
+    uint64_t startOffset = state._offset;
+    long chunkScore = _scan(chunk, state, limit);
+    size_t scanned = state._offset - startOffset;
+    if (scanned > 0)
+    {
+        state._lineOpen = chunk[scanned - 1] != LINE_END;
+    }
+    return chunkScore;
+}
+
+long PhraseMatcher::_scan(std::string_view text, ScanState &state, ScoreLimit *limit) const
+{
+    char folded[FOLD_BLOCK_SIZE];
+    long textScore = 0;
+    long sharedScore = 0; //the part of the text score already added to the limit
+    long stopScore = LONG_MAX; //the text score at which the message reaches its threshold
+    size_t scanned = 0;
+    uint32_t current = state._current;
+    while (scanned < text.size() && textScore < stopScore)
+    {
+        if (limit != nullptr) //other scans of the message may have added to it since last block
+        {
+            long messageScore = limit->_add(textScore - sharedScore);
+            sharedScore = textScore;
+            stopScore = textScore + limit->_threshold - messageScore;
+            if (textScore >= stopScore)
+            {
+                break;
+            }
+        }
+        size_t blockSize = std::min(FOLD_BLOCK_SIZE, text.size() - scanned);
+        foldAsciiLower(text.data() + scanned, folded, blockSize);
+        for (size_t blockIdx = 0; blockIdx < blockSize; blockIdx++)
+        {
+            if (folded[blockIdx] == LINE_END)
+            {
+                current = ROOT_STATE;
+                state._lineCount++;
+                continue;
+            }
+            current = _step(current, (unsigned char) folded[blockIdx]);
+            uint32_t found = testBit(_tables.terminalBits, current) ? current :
+                             _outputLinkOf(current);
+            while (found != NO_STATE)
+            {
+                uint32_t phrase = rankBit(_tables.terminalBits, _tables.terminalRank, found);
+                //positions are absolute over everything scanned with this state, so nothing has
+                //to be reset between lines
+                uint64_t start = state._offset + scanned + blockIdx + 1 -
+                                 _tables.phraseLength[phrase];
+                if (start >= state._nextAllowed[phrase])
+                {
+                    state._nextAllowed[phrase] = start + _tables.phraseLength[phrase];
+                    textScore += _tables.phraseScore[phrase];
+                    state._matchCount++;
+                    if (textScore >= stopScore) //the verdict is known, the rest isn't read
+                    {
+                        blockSize = blockIdx + 1;
+                    }
+                }
+                found = _outputLinkOf(found);
+            }
+        }
+        scanned += blockSize;
+    }
+    if (limit != nullptr)
+    {
+        limit->_add(textScore - sharedScore);
+    }
+    //only the scanned part counts, every position counted so far is still behind the offset
+    state._offset += scanned;
+    state._current = current;
+    return textScore;
+}
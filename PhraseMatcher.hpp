@@ -0,0 +1,284 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <atomic>
+#include "HashMap.hpp"
+
+#ifndef EX3_PHRASEMATCHER_HPP
+#define EX3_PHRASEMATCHER_HPP
+
+const size_t BITS_IN_WORD = 64;
+
+/**
+ * @brief This class represents a dictionary of scored phrases compiled into an Aho-Corasick
+ * automaton, so a line is scanned for all phrases at once in a single pass.
+ * the automaton is kept in flat tables, which are either owned by the matcher or borrowed from
+ * a memory mapped dictionary file
+ */
+class PhraseMatcher
+{
+public:
+    /**
+     * @brief the flat tables of the automaton. states are numbered from the root (0) in breadth
+     * first order and the edges of a state are sorted by label, so edge e always leads to state
+     * e + 1 and needs no target. which states end a phrase and which have an output link are kept
+     * as bits, with the number of bits set before every word of 64 states, so the phrase of a
+     * state and its output link are found by counting bits instead of taking an entry per state
+     */
+    struct Tables
+    {
+        size_t stateCount = 0;
+        size_t phraseCount = 0;
+        size_t outputLinkCount = 0;
+        const uint32_t *edgeStart = nullptr; //stateCount + 1 entries
+        const unsigned char *edgeLabel = nullptr; //stateCount - 1 entries
+        const uint32_t *rootNext = nullptr; //an entry for every byte value
+        const uint32_t *fail = nullptr; //stateCount entries
+        const uint64_t *terminalBits = nullptr; //bitWordCount(stateCount) entries
+        const uint32_t *terminalRank = nullptr; //bitWordCount(stateCount) entries
+        const uint64_t *outputBits = nullptr; //bitWordCount(stateCount) entries
+        const uint32_t *outputRank = nullptr; //bitWordCount(stateCount) entries
+        const uint32_t *outputLink = nullptr; //outputLinkCount entries
+        const uint32_t *phraseLength = nullptr; //phraseCount entries, in the order of the states
+        const int32_t *phraseScore = nullptr; //phraseCount entries
+    };
+
+    /**
+     * @param stateCount the number of states
+     * @return the number of words a bit per state takes
+     */
+    static size_t bitWordCount(size_t stateCount)
+    {
+        return (stateCount + BITS_IN_WORD - 1) / BITS_IN_WORD;
+    }
+
+    /**
+     * @brief per scan state of the matcher. holds for every phrase the first position at which
+     * it may be counted again, so occurrences of a phrase are counted without overlapping.
+     * a state may be reused for any number of lines and messages, but not by two threads at once
+     */
+    class ScanState
+    {
+    public:
+        /**
+         * @brief constructor for this class
+         * @param matcher the matcher this state will be used with
+         */
+        explicit ScanState(const PhraseMatcher &matcher);
+
+        /**
+         * @return number of bytes scanned with this state
+         */
+        uint64_t bytesScanned() const
+        {
+            return _offset;
+        }
+
+        /**
+         * @return number of lines scanned with this state, a text that doesn't end with a
+         * newline counts its last line too
+         */
+        uint64_t linesScanned() const
+        {
+            return _lineCount + (_lineOpen ? 1 : 0);
+        }
+
+        /**
+         * @return number of phrase occurrences counted with this state
+         */
+        uint64_t matchCount() const
+        {
+            return _matchCount;
+        }
+
+        /**
+         * @brief ends the stream scanned with scoreChunk, so the next chunk starts a new line.
+         * nothing else is reset, and it's safe to call without a stream
+         */
+        void endStream();
+
+    private:
+        friend class PhraseMatcher;
+        std::vector<uint64_t> _nextAllowed;
+        uint64_t _offset;
+        uint64_t _lineCount;
+        uint64_t _matchCount;
+        uint32_t _current; //the automaton state a stream stopped at
+        bool _lineOpen; //true if the last chunk of a stream ended inside a line
+    };
+
+    /**
+     * @brief a score at which scanning a message stops, because its verdict is already known.
+     * scores are never negative, so once the running score reaches the threshold it stays there.
+     * all the scans of a message share a limit, so when a message is scanned in parts, a part
+     * that reaches it stops the others too
+     */
+    class ScoreLimit
+    {
+    public:
+        /**
+         * @brief constructor for this class
+         * @param threshold the score to stop at
+         */
+        explicit ScoreLimit(long threshold) : _threshold(threshold), _total(0)
+        {
+        }
+
+        /**
+         * @return true if the scans of the message reached the threshold, false otherwise
+         */
+        bool reached() const
+        {
+            return _total.load(std::memory_order_relaxed) >= _threshold;
+        }
+
+    private:
+        friend class PhraseMatcher;
+        friend class TokenMatcher;
+        long _threshold;
+        std::atomic<long> _total;
+
+        /**
+         * @brief adds to the score of the message
+         * @param score the score to add
+         * @return the score of the message so far
+         */
+        long _add(long score)
+        {
+            return _total.fetch_add(score, std::memory_order_relaxed) + score;
+        }
+    };
+
+    /**
+     * @brief compiles the phrases of a map into an automaton. the phrases are sorted and the
+     * trie is laid out level by level straight from the sorted ranges, without a node per state.
+     * the phrases are only read while building, so the strings they view may be freed after
+     * @param scoreMap the map from phrases to their score
+     */
+    explicit PhraseMatcher(const HashMap<std::string_view, int> &scoreMap);
+
+    /**
+     * @brief constructor for a matcher over tables it doesn't own
+     * @param tables the tables of the automaton
+     * @param owner keeps the memory of the tables alive for as long as the matcher exists
+     */
+    PhraseMatcher(const Tables &tables, std::shared_ptr<const void> owner);
+
+    PhraseMatcher(const PhraseMatcher &other) = delete;
+
+    PhraseMatcher(PhraseMatcher &&other) = default;
+
+    PhraseMatcher &operator=(const PhraseMatcher &other) = delete;
+
+    PhraseMatcher &operator=(PhraseMatcher &&other) = default;
+
+    /**
+     * @brief scores a piece of text in place. the text is lower cased as it's read, and matching
+     * starts over at every newline, so a phrase never matches across lines. within a line every
+     * phrase is counted the same way as repeatedly calling line.find(phrase, start) and moving
+     * start to the end of the previous occurrence
+     * @param text the text to score, any number of whole lines
+     * @param state the scan state to use
+     * @param limit if given, scanning stops once the message this text is part of reaches its
+     * threshold, which is checked after every match and shared with other scans every block
+     * @return the sum of the scores of all the phrases found in the text. a scan stopped by its
+     * limit returns the score it got to, which is enough to reach the threshold
+     */
+    long scoreText(std::string_view text, ScanState &state, ScoreLimit *limit = nullptr) const;
+
+    /**
+     * @brief scores the next chunk of a stream. matching carries on from where the previous
+     * chunk left off, so chunks may be cut anywhere, even in the middle of a phrase, and the
+     * scores of the chunks add up to the score of scoreText over the whole stream. the stream
+     * ends with endStream, or with the next call to scoreText with the same state
+     * @param chunk the next bytes of the stream
+     * @param state the scan state of the stream
+     * @param limit if given, scanning stops once the message reaches its threshold, the same
+     * as in scoreText. the rest of a stopped stream should not be scanned
+     * @return the sum of the scores of the phrases that end in the chunk
+     */
+    long scoreChunk(std::string_view chunk, ScanState &state, ScoreLimit *limit = nullptr) const;
+
+    /**
+     * @return number of phrases in this matcher
+     */
+    size_t phraseCount() const
+    {
+        return _tables.phraseCount;
+    }
+
+    /**
+     * @param phraseIdx the index of the phrase
+     * @return the score of the phrase in that index
+     */
+    int phraseScore(size_t phraseIdx) const
+    {
+        return _tables.phraseScore[phraseIdx];
+    }
+
+    /**
+     * @return the tables of the automaton
+     */
+    const Tables &tables() const
+    {
+        return _tables;
+    }
+
+private:
+    Tables _tables;
+    std::shared_ptr<const void> _owner;
+    //storage of the tables when they are owned by this matcher
+    std::vector<uint32_t> _edgeStart;
+    std::vector<unsigned char> _edgeLabel;
+    std::vector<uint32_t> _rootNext;
+    std::vector<uint32_t> _fail;
+    std::vector<uint64_t> _terminalBits;
+    std::vector<uint32_t> _terminalRank;
+    std::vector<uint64_t> _outputBits;
+    std::vector<uint32_t> _outputRank;
+    std::vector<uint32_t> _outputLink;
+    std::vector<uint32_t> _phraseLength;
+    std::vector<int32_t> _phraseScore;
+
+    /**
+     * @brief points the tables at the owned storage
+     */
+    void _useOwnedStorage();
+
+    /**
+     * @brief getter method for the goto function of the automaton
+     * @param state the state to move from
+     * @param label the byte to move by
+     * @return the next state, or the no state constant if there is no such edge
+     */
+    uint32_t _child(uint32_t state, unsigned char label) const;
+
+    /**
+     * @brief advances the automaton by a single byte, following failure links as needed
+     * @param state the current state
+     * @param label the byte read
+     * @return the next state
+     */
+    uint32_t _step(uint32_t state, unsigned char label) const;
+
+    /**
+     * @param state a state
+     * @return the closest state ending a phrase that the state reaches through failure links,
+     * not counting itself, or the no state constant if there is none
+     */
+    uint32_t _outputLinkOf(uint32_t state) const;
+
+    /**
+     * @brief scans text from the automaton state the scan state stopped at, and leaves it at the
+     * state the scan ended in. lines are counted at every newline only
+     * @param text the text to scan
+     * @param state the scan state to use
+     * @param limit the score to stop at, if any
+     * @return the sum of the scores of the phrases found
+     */
+    long _scan(std::string_view text, ScanState &state, ScoreLimit *limit) const;
+};
+
+#endif //EX3_PHRASEMATCHER_HPP
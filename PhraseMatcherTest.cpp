@@ -0,0 +1,261 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <random>
+#include <algorithm>
+#include <cctype>
+#include "HashMap.hpp"
+#include "PhraseMatcher.hpp"
+#include "TestCheck.hpp"
+
+const int RANDOM_ROUNDS = 3000;
+const int MAX_PHRASES = 12;
+const int MAX_PHRASE_LENGTH = 6;
+const int MAX_MESSAGE_LENGTH = 200;
+const int MAX_PHRASE_SCORE = 9;
+const unsigned RANDOM_SEED = 11;
+//few letters, so phrases overlap each other and themselves often
+const char PHRASE_LETTERS[] = "aab ";
+//the same letters in both cases, newlines, and bytes that only some letters fold
+const char MESSAGE_LETTERS[] = "aAabBb \n\n\xc9z";
+
+/**
+ * @brief scores a message the way SpamDetector did before the matcher: every line is lower cased
+ * and every phrase is searched for with line.find, starting after the previous occurrence
+ * @param phrases the phrases and their scores
+ * @param message the message to score
+ * @return the score of the message
+ */
+long referenceScore(const std::map<std::string, int> &phrases, const std::string &message)
+{
+    long score = 0;
+    size_t lineStart = 0;
+    while (lineStart <= message.size())
+    {
+        size_t lineEnd = std::min(message.find('\n', lineStart), message.size());
+        std::string line = message.substr(lineStart, lineEnd - lineStart);
+        std::transform(line.begin(), line.end(), line.begin(), [](unsigned char c)
+        { return std::tolower(c); });
+        for (const auto &pair : phrases)
+        {
+            if (pair.first.empty()) //the old loop never ended on an empty phrase
+            {
+                continue;
+            }
+            size_t start = line.find(pair.first);
+            while (start != std::string::npos)
+            {
+                score += pair.second;
+                start = line.find(pair.first, start + pair.first.size());
+            }
+        }
+        lineStart = lineEnd + 1;
+    }
+    return score;
+}
+
+/**
+ * @param phrases the phrases and their scores
+ * @return a matcher over the phrases
+ */
+PhraseMatcher makeMatcher(const std::map<std::string, int> &phrases)
+{
+    HashMap<std::string_view, int> scoreMap;
+    for (const auto &pair : phrases)
+    {
+        scoreMap.insert(pair.first, pair.second);
+    }
+    return PhraseMatcher(scoreMap);
+}
+
+/**
+ * @param random the random generator
+ * @param letters the letters to pick from
+ * @param length the length of the string
+ * @return a random string of the letters
+ */
+std::string randomString(std::mt19937 &random, std::string_view letters, size_t length)
+{
+    std::uniform_int_distribution<size_t> letter(0, letters.size() - 1);
+    std::string result;
+    for (size_t letterIdx = 0; letterIdx < length; letterIdx++)
+    {
+        result += letters[letter(random)];
+    }
+    return result;
+}
+
+/**
+ * @brief phrases that overlap, or that only match once the text is lower cased
+ */
+void testKnownMessages()
+{
+    std::map<std::string, int> phrases = {{"aa", 1}, {"aba", 10}, {"ab", 100}, {"b", 1000},
+                                          {"Free", 10000}, {"free money", 100000}};
+    PhraseMatcher matcher = makeMatcher(phrases);
+    PhraseMatcher::ScanState state(matcher);
+    std::vector<std::string> messages = {"aaaa", "ababa", "AbAbA", "aa\naa", "a\nb", "ab\nab\n",
+                                         "FREE MONEY\nfree\nmoney", "Free", "", "\n", "aaa"};
+    for (const auto &message : messages)
+    {
+        check(matcher.scoreText(message, state) == referenceScore(phrases, message),
+              "known message \"" + message + "\"");
+    }
+    check(matcher.scoreText("aaaa", state) == 2, "a phrase overlapping itself is counted apart");
+    check(matcher.scoreText("ababa", state) == 10 + 200 + 2000,
+          "overlapping phrases are counted each on its own");
+    check(matcher.scoreText("a\na", state) == 0, "phrases don't match across lines");
+    check(matcher.scoreText("FREE", state) == 0, "a phrase with capitals never matches");
+}
+
+/**
+ * @brief random phrases and messages over few letters, compared with the old line.find loop.
+ * a single scan state is used for every message of a round, so nothing may carry over from one
+ * message to the next
+ */
+void testRandomMessages()
+{
+    std::mt19937 random(RANDOM_SEED);
+    std::uniform_int_distribution<int> phraseCount(1, MAX_PHRASES);
+    std::uniform_int_distribution<size_t> phraseLength(1, MAX_PHRASE_LENGTH);
+    std::uniform_int_distribution<size_t> messageLength(0, MAX_MESSAGE_LENGTH);
+    std::uniform_int_distribution<int> score(0, MAX_PHRASE_SCORE);
+    std::uniform_int_distribution<int> kind(0, 9);
+    bool same = true;
+    for (int round = 0; round < RANDOM_ROUNDS && same; round++)
+    {
+        std::string message = randomString(random, MESSAGE_LETTERS, messageLength(random));
+        std::map<std::string, int> phrases;
+        for (int phraseIdx = phraseCount(random); phraseIdx > 0; phraseIdx--)
+        {
+            std::string phrase;
+            switch (kind(random))
+            {
+                case 0: //taken from the message, maybe across a newline or in capitals
+                {
+                    size_t length = phraseLength(random);
+                    if (message.size() >= length)
+                    {
+                        std::uniform_int_distribution<size_t> from(0, message.size() - length);
+                        phrase = message.substr(from(random), length);
+                    }
+                    break;
+                }
+                case 1: //with letters of both cases
+                    phrase = randomString(random, MESSAGE_LETTERS, phraseLength(random));
+                    break;
+                default:
+                    phrase = randomString(random, PHRASE_LETTERS, phraseLength(random));
+                    break;
+            }
+            phrases[phrase] = score(random);
+        }
+        PhraseMatcher matcher = makeMatcher(phrases);
+        PhraseMatcher::ScanState state(matcher);
+        for (int repeat = 0; repeat < 2; repeat++)
+        {
+            same = same && matcher.scoreText(message, state) == referenceScore(phrases, message);
+        }
+        std::string other = randomString(random, MESSAGE_LETTERS, messageLength(random));
+        same = same && matcher.scoreText(other, state) == referenceScore(phrases, other);
+    }
+    check(same, "random messages score the same as the line.find loop");
+}
+
+/**
+ * @brief scores a message as a stream cut at the given points
+ * @param matcher the matcher
+ * @param message the message
+ * @param cuts the points to cut at, in order
+ * @param state the scan state of the stream
+ * @return the sum of the scores of the chunks
+ */
+long scoreCut(const PhraseMatcher &matcher, std::string_view message,
+              const std::vector<size_t> &cuts, PhraseMatcher::ScanState &state)
+{
+    long score = 0;
+    size_t chunkStart = 0;
+    for (size_t cut : cuts)
+    {
+        score += matcher.scoreChunk(message.substr(chunkStart, cut - chunkStart), state);
+        chunkStart = cut;
+    }
+    score += matcher.scoreChunk(message.substr(chunkStart), state);
+    state.endStream();
+    return score;
+}
+
+/**
+ * @brief chunks cut inside a phrase, inside an occurrence that mustn't be counted again, or
+ * around a newline
+ */
+void testKnownChunks()
+{
+    std::map<std::string, int> phrases = {{"aa", 1}, {"free money", 10}, {"ab", 100}};
+    PhraseMatcher matcher = makeMatcher(phrases);
+    PhraseMatcher::ScanState state(matcher);
+    check(scoreCut(matcher, "aaaa", {1, 3}, state) == 2,
+          "a phrase overlapping itself is counted apart across chunks");
+    check(scoreCut(matcher, "aaa", {2}, state) == 1,
+          "an occurrence in one chunk isn't counted again in the next");
+    check(scoreCut(matcher, "FREE MONEY", {2, 2, 7}, state) == 10,
+          "a phrase cut in three, with an empty chunk");
+    check(scoreCut(matcher, "a\nb", {1, 2}, state) == 0, "a newline chunk ends the line");
+    check(scoreCut(matcher, "a", {}, state) + scoreCut(matcher, "b", {}, state) == 0,
+          "a phrase doesn't match across streams");
+    check(scoreCut(matcher, "aa", {1}, state) == 1 && matcher.scoreText("aa", state) == 1,
+          "a state is reusable after a stream");
+    check(state.linesScanned() == 9, "every stream counts its last line");
+}
+
+/**
+ * @brief random messages scored as streams cut at random points, including inside phrases and
+ * single bytes, compared with scoring them whole
+ */
+void testRandomChunks()
+{
+    std::mt19937 random(RANDOM_SEED + 1);
+    std::uniform_int_distribution<int> phraseCount(1, MAX_PHRASES);
+    std::uniform_int_distribution<size_t> phraseLength(1, MAX_PHRASE_LENGTH);
+    std::uniform_int_distribution<size_t> messageLength(0, MAX_MESSAGE_LENGTH);
+    std::uniform_int_distribution<int> score(0, MAX_PHRASE_SCORE);
+    std::uniform_int_distribution<size_t> cutCount(0, MAX_MESSAGE_LENGTH / 4);
+    bool same = true;
+    for (int round = 0; round < RANDOM_ROUNDS && same; round++)
+    {
+        std::map<std::string, int> phrases;
+        for (int phraseIdx = phraseCount(random); phraseIdx > 0; phraseIdx--)
+        {
+            phrases[randomString(random, PHRASE_LETTERS, phraseLength(random))] = score(random);
+        }
+        std::string message = randomString(random, MESSAGE_LETTERS, messageLength(random));
+        std::uniform_int_distribution<size_t> cutAt(0, message.size());
+        std::vector<size_t> cuts;
+        for (size_t cutIdx = cutCount(random); cutIdx > 0; cutIdx--)
+        {
+            cuts.push_back(cutAt(random));
+        }
+        std::sort(cuts.begin(), cuts.end());
+        PhraseMatcher matcher = makeMatcher(phrases);
+        PhraseMatcher::ScanState state(matcher);
+        long whole = matcher.scoreText(message, state);
+        same = same && whole == referenceScore(phrases, message) &&
+               scoreCut(matcher, message, cuts, state) == whole &&
+               matcher.scoreText(message, state) == whole;
+    }
+    check(same, "random messages score the same cut into chunks as whole");
+}
+
+/**
+ * @brief runs the tests of PhraseMatcher
+ * @return 0 if all checks passed, exit failure constant otherwise
+ */
+int main()
+{
+    testKnownMessages();
+    testRandomMessages();
+    testKnownChunks();
+    testRandomChunks();
+    return checkResult();
+}
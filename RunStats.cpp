@@ -0,0 +1,107 @@
+#include <sys/resource.h>
+#include "RunStats.hpp"
+
+const char *const PHASE_NAMES[RunStats::PHASE_COUNT] = {"arguments", "db_load", "map_build",
+                                                         "matcher_build", "scan"};
+
+namespace
+{
+    /**
+     * @brief writes a json array of numbers
+     * @param out the stream to write to
+     * @param values the numbers to write
+     */
+    void writeArray(std::ostream &out, const std::vector<int> &values)
+    {
+        out << '[';
+        for (size_t valueIdx = 0; valueIdx < values.size(); valueIdx++)
+        {
+            out << (valueIdx == 0 ? "" : ",") << values[valueIdx];
+        }
+        out << ']';
+    }
+}
+
+void writeMapStats(std::ostream &out, const HashMapStats &mapStats)
+{
+    out << "{\"size\":" << mapStats.size
+        << ",\"capacity\":" << mapStats.capacity
+        << ",\"load_factor\":" << mapStats.loadFactor
+        << ",\"max_probe\":" << mapStats.maxProbeLength
+        << ",\"average_probe\":" << mapStats.averageProbeLength
+        << ",\"rehashes\":" << mapStats.rehashCount
+        << ",\"bytes\":" << mapStats.bytesAllocated
+        << ",\"collisions\":" << mapStats.collisions
+        << ",\"bucket_histogram\":";
+    writeArray(out, mapStats.bucketHistogram);
+    out << ",\"probe_histogram\":";
+    writeArray(out, mapStats.probeHistogram);
+    out << '}';
+}
+
+RunStats::PhaseTimer::PhaseTimer(RunStats &stats, Phase phase) : _stats(stats), _phase(phase)
+{
+    if (_stats._enabled)
+    {
+        _start = std::chrono::steady_clock::now();
+    }
+}
+
+RunStats::PhaseTimer::~PhaseTimer()
+{
+    if (_stats._enabled)
+    {
+        _stats._phaseSeconds[_phase] += std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - _start).count();
+    }
+}
+
+RunStats::RunStats(bool enabled) : _enabled(enabled), _phaseSeconds(), _bytesScanned(0),
+                                   _linesScanned(0), _matchCount(0), _messageCount(0),
+                                   _dictionaryEntries(0), _hasMapStats(false)
+{
+}
+
+void RunStats::addMessages(size_t messages)
+{
+    _messageCount += messages;
+}
+
+void RunStats::setDictionaryEntries(size_t entries)
+{
+    _dictionaryEntries = entries;
+}
+
+void RunStats::setMapStats(const HashMapStats &mapStats)
+{
+    _hasMapStats = true;
+    _mapStats = mapStats;
+}
+
+void RunStats::write(std::ostream &out) const
+{
+    if (!_enabled)
+    {
+        return;
+    }
+    struct rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    out << "{\"phases\":{";
+    for (int phase = 0; phase < PHASE_COUNT; phase++)
+    {
+        out << (phase == 0 ? "" : ",") << '"' << PHASE_NAMES[phase] << "\":"
+            << _phaseSeconds[phase];
+    }
+    out << "},\"bytes_scanned\":" << _bytesScanned
+        << ",\"lines_scanned\":" << _linesScanned
+        << ",\"matches\":" << _matchCount
+        << ",\"messages\":" << _messageCount
+        << ",\"dictionary_entries\":" << _dictionaryEntries
+        << ",\"peak_rss_kb\":" << usage.ru_maxrss; //kilobytes on linux
+    if (_hasMapStats)
+    {
+        out << ",\"map\":";
+        writeMapStats(out, _mapStats);
+    }
+    out << "}" << std::endl;
+}
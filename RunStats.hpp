@@ -0,0 +1,125 @@
+#include <ostream>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include "HashMap.hpp"
+
+#ifndef EX3_RUNSTATS_HPP
+#define EX3_RUNSTATS_HPP
+
+/**
+ * @brief This class collects the timings and counters of a single run, printed as json by the
+ * stats option. a disabled instance ignores everything it's given, so it can be passed around
+ * unconditionally
+ */
+class RunStats
+{
+public:
+    /**
+     * @brief the phases of a run, in the order they happen
+     */
+    enum Phase
+    {
+        PHASE_ARGUMENTS, PHASE_DB_LOAD, PHASE_MAP_BUILD, PHASE_MATCHER_BUILD, PHASE_SCAN,
+        PHASE_COUNT
+    };
+
+    /**
+     * @brief times a phase from its construction to its destruction
+     */
+    class PhaseTimer
+    {
+    public:
+        /**
+         * @brief starts timing a phase
+         * @param stats the stats to add the time to
+         * @param phase the phase being timed
+         */
+        PhaseTimer(RunStats &stats, Phase phase);
+
+        /**
+         * @brief d'tor for this class, adds the elapsed time to the phase
+         */
+        ~PhaseTimer();
+
+        PhaseTimer(const PhaseTimer &other) = delete;
+
+        PhaseTimer &operator=(const PhaseTimer &other) = delete;
+
+    private:
+        RunStats &_stats;
+        Phase _phase;
+        std::chrono::steady_clock::time_point _start;
+    };
+
+    /**
+     * @brief constructor for this class
+     * @param enabled whether anything should be collected
+     */
+    explicit RunStats(bool enabled);
+
+    /**
+     * @return true if the stats are collected, false otherwise
+     */
+    bool enabled() const
+    {
+        return _enabled;
+    }
+
+    /**
+     * @brief adds the counters of a scan state, once it won't be used anymore
+     * @tparam ScanStateT the scan state of a PhraseMatcher or a TokenMatcher
+     * @param scanState the scan state
+     */
+    template <typename ScanStateT>
+    void addScan(const ScanStateT &scanState)
+    {
+        _bytesScanned += scanState.bytesScanned();
+        _linesScanned += scanState.linesScanned();
+        _matchCount += scanState.matchCount();
+    }
+
+    /**
+     * @brief adds to the number of messages checked
+     * @param messages the number of messages
+     */
+    void addMessages(size_t messages);
+
+    /**
+     * @brief setter method for the number of phrases in the dictionary
+     * @param entries the number of phrases
+     */
+    void setDictionaryEntries(size_t entries);
+
+    /**
+     * @brief setter method for the layout of the map the dictionary was built from
+     * @param mapStats the stats of the map
+     */
+    void setMapStats(const HashMapStats &mapStats);
+
+    /**
+     * @brief writes the stats as a single line json object
+     * @param out the stream to write to
+     */
+    void write(std::ostream &out) const;
+
+private:
+    bool _enabled;
+    double _phaseSeconds[PHASE_COUNT];
+    uint64_t _bytesScanned;
+    uint64_t _linesScanned;
+    uint64_t _matchCount;
+    size_t _messageCount;
+    size_t _dictionaryEntries;
+    bool _hasMapStats;
+    HashMapStats _mapStats;
+};
+
+/**
+ * @brief writes the layout of a map as a json object
+ * @param out the stream to write to
+ * @param mapStats the stats of the map
+ */
+void writeMapStats(std::ostream &out, const HashMapStats &mapStats);
+
+#endif //EX3_RUNSTATS_HPP
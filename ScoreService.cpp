@@ -0,0 +1,428 @@
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <algorithm>
+#include <iterator>
+#include <csignal>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "ScoreService.hpp"
+
+const int LISTEN_BACKLOG = 128;
+const int BITS_IN_BYTE = 8;
+const time_t DB_POLL_SECONDS = 1;
+
+namespace
+{
+    /**
+     * @brief fills an address for a socket path
+     * @param socketPath the path of the socket
+     * @param address the address to fill
+     * @throw std::runtime_error if the path doesn't fit in an address
+     */
+    void makeAddress(const std::string &socketPath, sockaddr_un &address)
+    {
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path))
+        {
+            throw std::runtime_error(SOCKET_ERROR);
+        }
+        std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    }
+
+    /**
+     * @brief connects to a socket path
+     * @param socketPath the path of the socket
+     * @return the connected socket, or -1 if nothing listens there
+     */
+    int connectTo(const std::string &socketPath)
+    {
+        sockaddr_un address;
+        makeAddress(socketPath, address);
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            return -1;
+        }
+        if (connect(fd, (const sockaddr *) &address, sizeof(address)) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    /**
+     * @brief reads an exact number of bytes
+     * @param fd the socket to read from
+     * @param buffer the buffer to read into
+     * @param size the number of bytes to read
+     * @return true if all bytes were read, false on end of stream or error
+     */
+    bool readExactly(int fd, char *buffer, size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t received = read(fd, buffer, size);
+            if (received < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (received <= 0)
+            {
+                return false;
+            }
+            buffer += received;
+            size -= (size_t) received;
+        }
+        return true;
+    }
+
+    /**
+     * @brief writes an exact number of bytes. a closed peer is reported instead of raising
+     * SIGPIPE
+     * @param fd the socket to write to
+     * @param buffer the bytes to write
+     * @param size the number of bytes to write
+     * @return true if all bytes were written, false on error
+     */
+    bool writeExactly(int fd, const char *buffer, size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t sent = send(fd, buffer, size, MSG_NOSIGNAL);
+            if (sent < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (sent <= 0)
+            {
+                return false;
+            }
+            buffer += sent;
+            size -= (size_t) sent;
+        }
+        return true;
+    }
+
+    /**
+     * @brief writes a number as big endian bytes
+     * @param value the number
+     * @param bytes the buffer to write to
+     * @param size the number of bytes to write
+     */
+    void encodeNumber(uint64_t value, char *bytes, size_t size)
+    {
+        for (size_t byteIdx = 0; byteIdx < size; byteIdx++)
+        {
+            bytes[size - 1 - byteIdx] = (char) (value >> (byteIdx * BITS_IN_BYTE));
+        }
+    }
+
+    /**
+     * @brief reads a number from big endian bytes
+     * @param bytes the buffer to read from
+     * @param size the number of bytes to read
+     * @return the number
+     */
+    uint64_t decodeNumber(const char *bytes, size_t size)
+    {
+        uint64_t value = 0;
+        for (size_t byteIdx = 0; byteIdx < size; byteIdx++)
+        {
+            value = (value << BITS_IN_BYTE) | (unsigned char) bytes[byteIdx];
+        }
+        return value;
+    }
+
+    /**
+     * @brief getter method for what identifies the current contents of a file: the file itself,
+     * its size and its modification time. replacing or rewriting the file changes it
+     * @param filePath the path of the file
+     * @return the version of the file, or an empty string if there is no such file
+     */
+    std::string fileVersion(const std::string &filePath)
+    {
+        struct stat fileStat;
+        if (stat(filePath.c_str(), &fileStat) != 0)
+        {
+            return "";
+        }
+        return std::to_string(fileStat.st_dev) + ':' + std::to_string(fileStat.st_ino) + ':' +
+               std::to_string(fileStat.st_size) + ':' + std::to_string(fileStat.st_mtim.tv_sec) +
+               '.' + std::to_string(fileStat.st_mtim.tv_nsec);
+    }
+
+    /**
+     * @brief builds the matcher of a database again and publishes it to a server. requests keep
+     * being scored with the previous matcher meanwhile, and keep it if the database is invalid
+     * @param server the server to publish to
+     * @param loadMatcher builds the matcher of the database
+     */
+    void reloadMatcher(ScoreServer &server, const MatcherLoader &loadMatcher)
+    {
+        RunStats reloadStats(false);
+        try
+        {
+            server.publish(std::make_shared<const Scorer>(loadMatcher(reloadStats)));
+        }
+        catch (...)
+        {
+            std::cerr << RELOAD_ERROR << std::endl;
+        }
+    }
+}
+
+ScoreServer::ScoreServer(std::shared_ptr<const Scorer> scorer, const std::string &socketPath) :
+        _scorer(std::move(scorer)), _socketPath(socketPath), _listenFd(-1), _stopping(false)
+{
+    sockaddr_un address;
+    makeAddress(socketPath, address);
+    int runningFd = connectTo(socketPath);
+    if (runningFd >= 0)
+    {
+        close(runningFd);
+        throw std::runtime_error(SOCKET_IN_USE_ERROR);
+    }
+    unlink(socketPath.c_str()); //a socket left behind by a server that didn't shut down
+    _listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (_listenFd < 0)
+    {
+        throw std::runtime_error(SOCKET_ERROR);
+    }
+    if (bind(_listenFd, (const sockaddr *) &address, sizeof(address)) != 0 ||
+        listen(_listenFd, LISTEN_BACKLOG) != 0)
+    {
+        close(_listenFd);
+        throw std::runtime_error(SOCKET_ERROR);
+    }
+}
+
+ScoreServer::~ScoreServer()
+{
+    _stopping = true;
+    _joinConnections();
+    close(_listenFd);
+    unlink(_socketPath.c_str());
+}
+
+void ScoreServer::run()
+{
+    while (!_stopping)
+    {
+        int clientFd = accept4(_listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (clientFd < 0)
+        {
+            if (_stopping || (errno != EINTR && errno != ECONNABORTED && errno != EMFILE &&
+                              errno != ENFILE))
+            {
+                break;
+            }
+            continue;
+        }
+        std::list<Connection> closed;
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            _takeClosed(closed);
+            _connections.push_back({clientFd, std::thread(), false});
+            auto connection = std::prev(_connections.end());
+            try
+            {
+                connection->thread = std::thread(&ScoreServer::_serve, this, connection);
+            }
+            catch (const std::system_error &) //out of threads, drop this client and keep going
+            {
+                _connections.erase(connection);
+                close(clientFd);
+            }
+        }
+        //joined without the lock, which their threads release as the last thing they do
+        for (auto &connection : closed)
+        {
+            connection.thread.join();
+        }
+    }
+    _joinConnections();
+}
+
+void ScoreServer::stop()
+{
+    _stopping = true;
+    shutdown(_listenFd, SHUT_RDWR); //wakes the thread blocked in accept
+    std::lock_guard<std::mutex> guard(_lock);
+    for (const auto &connection : _connections)
+    {
+        if (!connection.closed)
+        {
+            shutdown(connection.clientFd, SHUT_RD);
+        }
+    }
+}
+
+void ScoreServer::publish(std::shared_ptr<const Scorer> scorer)
+{
+    std::atomic_store(&_scorer, std::move(scorer));
+}
+
+void ScoreServer::_serve(std::list<Connection>::iterator connection)
+{
+    int clientFd = connection->clientFd;
+    try
+    {
+        std::string message;
+        char header[REQUEST_LENGTH_SIZE];
+        char response[RESPONSE_SCORE_SIZE];
+        while (readExactly(clientFd, header, REQUEST_LENGTH_SIZE))
+        {
+            uint64_t messageSize = decodeNumber(header, REQUEST_LENGTH_SIZE);
+            if (messageSize > MAX_REQUEST_SIZE)
+            {
+                break;
+            }
+            message.resize(messageSize);
+            if (!readExactly(clientFd, &message[0], message.size()))
+            {
+                break;
+            }
+            //the scorer is picked per request, so a long lived connection moves on to a
+            //published scorer too
+            long score = std::atomic_load(&_scorer)->score(message);
+            encodeNumber((uint64_t) score, response, RESPONSE_SCORE_SIZE);
+            if (!writeExactly(clientFd, response, RESPONSE_SCORE_SIZE))
+            {
+                break;
+            }
+        }
+    }
+    catch (...) //out of memory for the message, nothing to answer the client with
+    {
+    }
+    //closed under the lock, so stop can't shut down the descriptor once accept hands it out again
+    std::lock_guard<std::mutex> guard(_lock);
+    close(clientFd);
+    connection->closed = true;
+    _connectionClosed.notify_all();
+}
+
+void ScoreServer::_takeClosed(std::list<Connection> &closed)
+{
+    for (auto connection = _connections.begin(); connection != _connections.end();)
+    {
+        auto next = std::next(connection);
+        if (connection->closed)
+        {
+            closed.splice(closed.end(), _connections, connection);
+        }
+        connection = next;
+    }
+}
+
+void ScoreServer::_joinConnections()
+{
+    std::list<Connection> closed;
+    {
+        //idle connections see the end of their stream, busy ones finish their request first
+        std::unique_lock<std::mutex> guard(_lock);
+        for (const auto &connection : _connections)
+        {
+            if (!connection.closed)
+            {
+                shutdown(connection.clientFd, SHUT_RD);
+            }
+        }
+        _connectionClosed.wait(guard, [this]
+        {
+            return std::all_of(_connections.begin(), _connections.end(),
+                               [](const Connection &connection)
+                               { return connection.closed; });
+        });
+        closed.splice(closed.end(), _connections);
+    }
+    for (auto &connection : closed)
+    {
+        connection.thread.join();
+    }
+}
+
+long requestScore(const std::string &socketPath, std::string_view message)
+{
+    if (message.size() > MAX_REQUEST_SIZE)
+    {
+        throw std::invalid_argument(MESSAGE_SIZE_ERROR);
+    }
+    int fd = connectTo(socketPath);
+    if (fd < 0)
+    {
+        throw std::runtime_error(SOCKET_ERROR);
+    }
+    char header[REQUEST_LENGTH_SIZE];
+    char response[RESPONSE_SCORE_SIZE];
+    encodeNumber(message.size(), header, REQUEST_LENGTH_SIZE);
+    bool answered = writeExactly(fd, header, REQUEST_LENGTH_SIZE) &&
+                    writeExactly(fd, message.data(), message.size()) &&
+                    readExactly(fd, response, RESPONSE_SCORE_SIZE);
+    close(fd);
+    if (!answered)
+    {
+        throw std::runtime_error(PROTOCOL_ERROR);
+    }
+    return (long) decodeNumber(response, RESPONSE_SCORE_SIZE);
+}
+
+void serveDatabase(const std::string &dbPath, const std::string &socketPath,
+                   const MatcherLoader &loadMatcher, RunStats &stats)
+{
+    std::string loadedVersion = fileVersion(dbPath);
+    ScoreServer server(std::make_shared<const Scorer>(loadMatcher(stats)), socketPath);
+    //the signals are taken by a waiting thread instead of a handler, so stopping and reloading
+    //may lock. they are blocked before any other thread starts, and every thread inherits the mask
+    sigset_t serveSignals;
+    sigemptyset(&serveSignals);
+    sigaddset(&serveSignals, SIGINT);
+    sigaddset(&serveSignals, SIGTERM);
+    sigaddset(&serveSignals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &serveSignals, nullptr);
+    std::thread signalWaiter([&]
+                             {
+                                 const timespec pollInterval = {DB_POLL_SECONDS, 0};
+                                 std::string pendingVersion = loadedVersion;
+                                 while (true)
+                                 {
+                                     int signal = sigtimedwait(&serveSignals, nullptr,
+                                                               &pollInterval);
+                                     if (signal == SIGINT || signal == SIGTERM)
+                                     {
+                                         server.stop();
+                                         return;
+                                     }
+                                     //a file that is still being written keeps changing, so
+                                     //it's only loaded once it stays the same for an interval
+                                     std::string version = fileVersion(dbPath);
+                                     bool settled = version != loadedVersion &&
+                                                    version == pendingVersion;
+                                     pendingVersion = version;
+                                     if (signal == SIGHUP || settled)
+                                     {
+                                         loadedVersion = version;
+                                         reloadMatcher(server, loadMatcher);
+                                     }
+                                 }
+                             });
+    try
+    {
+        server.run();
+    }
+    catch (...)
+    {
+        kill(getpid(), SIGTERM); //releases the waiting thread
+        signalWaiter.join();
+        throw;
+    }
+    signalWaiter.join();
+}
@@ -0,0 +1,155 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <list>
+#include <thread>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include "Scorer.hpp"
+#include "RunStats.hpp"
+
+#ifndef EX3_SCORESERVICE_HPP
+#define EX3_SCORESERVICE_HPP
+
+#define SOCKET_ERROR "Could not use socket"
+#define SOCKET_IN_USE_ERROR "Socket is already served"
+#define PROTOCOL_ERROR "Invalid response from server"
+#define MESSAGE_SIZE_ERROR "Message is too long to send"
+#define RELOAD_ERROR "Could not reload database, still serving the previous one"
+
+//a request is the length of the message followed by the message, a response is the score.
+//both numbers are big endian. the server closes a connection whose request is longer than the
+//maximum request size without answering, so a client can't make it allocate more than that
+const size_t REQUEST_LENGTH_SIZE = 4;
+const size_t RESPONSE_SCORE_SIZE = 8;
+const size_t MAX_REQUEST_SIZE = 64 * 1024 * 1024;
+
+/**
+ * @brief This class represents a resident scorer that answers score requests over a unix domain
+ * socket. every connection is served on its own thread and may send any number of requests. the
+ * threads of closed connections are joined as new connections arrive, and the rest before run
+ * returns, so no thread outlives it. the scorer pools scan states between connections, so a short
+ * lived connection doesn't pay for a new one. a new scorer may be published at any time: each
+ * request scores with the scorer that was current when it arrived, and a replaced scorer is freed
+ * with the last request using it
+ */
+class ScoreServer
+{
+public:
+    /**
+     * @brief binds the socket. a leftover socket file nobody listens on is replaced
+     * @param scorer the scorer to score with
+     * @param socketPath the path to bind the socket at
+     * @throw std::runtime_error if the socket can't be bound or is served by another process
+     */
+    ScoreServer(std::shared_ptr<const Scorer> scorer, const std::string &socketPath);
+
+    /**
+     * @brief d'tor for this class, closes and removes the socket. connections still open, if run
+     * failed, are shut down and their threads joined
+     */
+    ~ScoreServer();
+
+    ScoreServer(const ScoreServer &other) = delete;
+
+    ScoreServer &operator=(const ScoreServer &other) = delete;
+
+    /**
+     * @brief accepts and serves connections until stop is called. once stopped, requests already
+     * received are answered and every connection thread is joined before it returns
+     */
+    void run();
+
+    /**
+     * @brief makes run return. may be called from any thread
+     */
+    void stop();
+
+    /**
+     * @brief replaces the scorer new requests are scored with, without waiting for the requests
+     * in flight. may be called from any thread
+     * @param scorer the new scorer
+     */
+    void publish(std::shared_ptr<const Scorer> scorer);
+
+private:
+    /**
+     * @brief a connection being served, and the thread serving it
+     */
+    struct Connection
+    {
+        int clientFd;
+        std::thread thread;
+        //set by the thread once it closed the connection, it's then only left to be joined
+        bool closed;
+    };
+
+    //only read and replaced through std::atomic_load and std::atomic_store
+    std::shared_ptr<const Scorer> _scorer;
+    std::string _socketPath;
+    int _listenFd;
+    std::atomic<bool> _stopping;
+    std::mutex _lock;
+    std::condition_variable _connectionClosed;
+    //a list, so a thread may hold on to its own entry while others are added and removed
+    std::list<Connection> _connections;
+
+    /**
+     * @brief answers the requests of a single connection until the client closes it
+     * @param connection the entry of the connection
+     */
+    void _serve(std::list<Connection>::iterator connection);
+
+    /**
+     * @brief moves the entries of closed connections out of the list. the lock must be held
+     * @param closed the list to move them to, their threads are joined once the lock is released
+     */
+    void _takeClosed(std::list<Connection> &closed);
+
+    /**
+     * @brief shuts down the reading side of every open connection, waits for all of them to close
+     * and joins their threads
+     */
+    void _joinConnections();
+};
+
+/**
+ * @brief the client side of the score server. connects, sends a single message and waits for
+ * its score
+ * @param socketPath the socket the server is bound at
+ * @param message the contents of the message
+ * @return the score of the message
+ * @throw std::runtime_error if the server can't be reached or doesn't answer
+ * @throw std::invalid_argument if the message is longer than the maximum request size
+ */
+long requestScore(const std::string &socketPath, std::string_view message);
+
+/**
+ * @brief builds the matcher of a database, timing the load with the given stats
+ */
+typedef std::function<PhraseMatcher(RunStats &)> MatcherLoader;
+
+/**
+ * @brief serves a database on a unix domain socket until the process gets SIGINT or SIGTERM. the
+ * database is loaded again on SIGHUP, and when the file changes and then stays unchanged for a
+ * poll interval. requests keep being scored with the previous matcher while it loads, and keep it
+ * if the database turns out invalid, which is reported on the standard error. the signals are
+ * blocked in the calling thread before any other thread starts, and taken by a thread that waits
+ * for them
+ * @param dbPath the database to serve, watched for changes
+ * @param socketPath the path to bind the socket at
+ * @param loadMatcher builds the matcher of the database, called once up front and again on every
+ * reload
+ * @param stats the stats to time the first load with
+ * @throw std::runtime_error if the socket can't be bound or is served by another process
+ * @throw std::invalid_argument if the first load fails
+ */
+void serveDatabase(const std::string &dbPath, const std::string &socketPath,
+                   const MatcherLoader &loadMatcher, RunStats &stats);
+
+#endif //EX3_SCORESERVICE_HPP
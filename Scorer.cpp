@@ -0,0 +1,112 @@
+#include <stdexcept>
+#include "Scorer.hpp"
+#include "DatabaseLoader.hpp"
+#include "DictionaryFile.hpp"
+
+Scorer::Scorer(PhraseMatcher matcher) : _matcher(std::move(matcher))
+{
+}
+
+long Scorer::score(std::string_view message) const
+{
+    return _score(message, nullptr);
+}
+
+bool Scorer::isSpam(std::string_view message, int threshold) const
+{
+    PhraseMatcher::ScoreLimit limit(threshold);
+    return _score(message, &limit) >= threshold;
+}
+
+long Scorer::_score(std::string_view message, PhraseMatcher::ScoreLimit *limit) const
+{
+    std::unique_ptr<PhraseMatcher::ScanState> scanState;
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        if (!_idleScanStates.empty())
+        {
+            scanState = std::move(_idleScanStates.back());
+            _idleScanStates.pop_back();
+        }
+    }
+    if (scanState == nullptr)
+    {
+        scanState.reset(new PhraseMatcher::ScanState(_matcher));
+    }
+    long score = _matcher.scoreText(message, *scanState, limit);
+    std::lock_guard<std::mutex> guard(_lock);
+    _idleScanStates.push_back(std::move(scanState));
+    return score;
+}
+
+HashMap<std::string_view, int> loadScoreMap(const std::string &dbPath, StringPool &phrasePool,
+                                            size_t threadCount, RunStats &stats)
+{
+    std::vector<std::string_view> words;
+    std::vector<int> scores;
+    {
+        RunStats::PhaseTimer timer(stats, RunStats::PHASE_DB_LOAD);
+        readFileIntoVectors(words, scores, phrasePool, dbPath, threadCount);
+    }
+    HashMap<std::string_view, int> wordsToScoreMap;
+    {
+        RunStats::PhaseTimer timer(stats, RunStats::PHASE_MAP_BUILD);
+        wordsToScoreMap = HashMap<std::string_view, int>(std::move(words), std::move(scores));
+    }
+    if (stats.enabled())
+    {
+        stats.setMapStats(wordsToScoreMap.stats());
+    }
+    return wordsToScoreMap;
+}
+
+PhraseMatcher loadMatcher(const std::string &dbPath, size_t threadCount, bool verifyDictionary,
+                          RunStats &stats)
+{
+    if (isDictionaryFile(dbPath))
+    {
+        RunStats::PhaseTimer timer(stats, RunStats::PHASE_DB_LOAD);
+        PhraseMatcher matcher = loadDictionaryFile(dbPath, verifyDictionary);
+        stats.setDictionaryEntries(matcher.phraseCount());
+        return matcher;
+    }
+    //the phrases live in the pool until the matcher is built, and are freed with it at once
+    StringPool phrasePool;
+    HashMap<std::string_view, int> wordsToScoreMap = loadScoreMap(dbPath, phrasePool,
+                                                                  threadCount, stats);
+    RunStats::PhaseTimer timer(stats, RunStats::PHASE_MATCHER_BUILD);
+    PhraseMatcher matcher(wordsToScoreMap);
+    stats.setDictionaryEntries(matcher.phraseCount());
+    return matcher;
+}
+
+TokenMatcher loadTokenMatcher(const std::string &dbPath, size_t threadCount, RunStats &stats)
+{
+    if (isDictionaryFile(dbPath))
+    {
+        throw std::invalid_argument(INVALID_DATABASE_ERROR);
+    }
+    StringPool phrasePool;
+    HashMap<std::string_view, int> wordsToScoreMap = loadScoreMap(dbPath, phrasePool,
+                                                                  threadCount, stats);
+    RunStats::PhaseTimer timer(stats, RunStats::PHASE_MATCHER_BUILD);
+    TokenMatcher matcher(wordsToScoreMap);
+    stats.setDictionaryEntries(matcher.phraseCount());
+    return matcher;
+}
+
+Scorer loadScorer(const std::string &dbPath, bool verifyDictionary)
+{
+    RunStats stats(false);
+    return Scorer(loadMatcher(dbPath, 1, verifyDictionary, stats));
+}
+
+Scorer parseScorer(std::string_view database)
+{
+    StringPool phrasePool;
+    std::vector<std::string_view> words;
+    std::vector<int> scores;
+    parseDatabaseBuffer(database, words, scores, phrasePool);
+    return Scorer(PhraseMatcher(HashMap<std::string_view, int>(std::move(words),
+                                                               std::move(scores))));
+}
@@ -0,0 +1,126 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+#include "HashMap.hpp"
+#include "PhraseMatcher.hpp"
+#include "TokenMatcher.hpp"
+#include "StringPool.hpp"
+#include "RunStats.hpp"
+
+#ifndef EX3_SCORER_HPP
+#define EX3_SCORER_HPP
+
+/**
+ * @brief This class represents a spam scorer for programs that embed the detector instead of
+ * running it. it's built once from a database, and then scores messages held in memory from any
+ * number of threads at once. scan states are pooled between calls, so once every thread scored a
+ * message a call allocates nothing
+ */
+class Scorer
+{
+public:
+    /**
+     * @brief constructor for this class
+     * @param matcher the matcher to score with
+     */
+    explicit Scorer(PhraseMatcher matcher);
+
+    Scorer(const Scorer &other) = delete;
+
+    Scorer &operator=(const Scorer &other) = delete;
+
+    /**
+     * @brief scores a message. may be called from any thread
+     * @param message the contents of the message
+     * @return the sum of the scores of all the phrases found in the message
+     */
+    long score(std::string_view message) const;
+
+    /**
+     * @brief checks if a message is spam. the message is only scanned up to the point where it
+     * reaches the threshold. may be called from any thread
+     * @param message the contents of the message
+     * @param threshold the threshold for if a message is a spam or not
+     * @return true if spam, false otherwise
+     */
+    bool isSpam(std::string_view message, int threshold) const;
+
+    /**
+     * @return the matcher this scorer scores with
+     */
+    const PhraseMatcher &matcher() const
+    {
+        return _matcher;
+    }
+
+private:
+    PhraseMatcher _matcher;
+    mutable std::mutex _lock;
+    mutable std::vector<std::unique_ptr<PhraseMatcher::ScanState>> _idleScanStates;
+
+    /**
+     * @brief scores a message with a pooled scan state
+     * @param message the contents of the message
+     * @param limit the score to stop at, if any
+     * @return the score of the message
+     */
+    long _score(std::string_view message, PhraseMatcher::ScoreLimit *limit) const;
+};
+
+/**
+ * @brief reads a csv database into a map from its phrases to their scores
+ * @param dbPath the database to read from
+ * @param phrasePool the pool to keep the phrases in, which the map views
+ * @param threadCount the most threads to parse with
+ * @param stats the stats to time the loading with
+ * @return the map of the database phrases
+ * @throw std::invalid_argument if the database is malformed
+ */
+HashMap<std::string_view, int> loadScoreMap(const std::string &dbPath, StringPool &phrasePool,
+                                            size_t threadCount, RunStats &stats);
+
+/**
+ * @brief builds the matcher of a database file, either a csv file or a compiled dictionary,
+ * which is mapped as is
+ * @param dbPath the database to read from
+ * @param threadCount the most threads to parse a csv database with
+ * @param verifyDictionary true to check the checksum of a compiled dictionary
+ * @param stats the stats to time the loading with
+ * @return the compiled matcher of the database phrases
+ * @throw std::invalid_argument if the database is malformed
+ */
+PhraseMatcher loadMatcher(const std::string &dbPath, size_t threadCount, bool verifyDictionary,
+                          RunStats &stats);
+
+/**
+ * @brief builds the whole word matcher of a csv database. compiled dictionaries only keep the
+ * automaton, not the phrases, so they can't be matched by words
+ * @param dbPath the database to read from
+ * @param threadCount the most threads to parse with
+ * @param stats the stats to time the loading with
+ * @return the whole word matcher of the database phrases
+ * @throw std::invalid_argument if the database is malformed or isn't a csv file
+ */
+TokenMatcher loadTokenMatcher(const std::string &dbPath, size_t threadCount, RunStats &stats);
+
+/**
+ * @brief builds a scorer from a database file, either a csv file or a compiled dictionary
+ * @param dbPath the database to read from
+ * @param verifyDictionary true to check the checksum of a compiled dictionary
+ * @return the scorer of the database
+ * @throw std::invalid_argument if the database is malformed
+ */
+Scorer loadScorer(const std::string &dbPath, bool verifyDictionary = false);
+
+/**
+ * @brief builds a scorer from the contents of a csv database held in memory
+ * @param database the "<phrase>,<score>" lines of the database
+ * @return the scorer of the database
+ * @throw std::invalid_argument if the database is malformed
+ */
+Scorer parseScorer(std::string_view database);
+
+#endif //EX3_SCORER_HPP
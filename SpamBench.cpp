@@ -0,0 +1,725 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <boost/filesystem.hpp>
+#include "HashMap.hpp"
+#include "ConcurrentHashMap.hpp"
+#include "PhraseMatcher.hpp"
+#include "DatabaseLoader.hpp"
+#include "MessageScanner.hpp"
+#include "CaseFold.hpp"
+#include "RunStats.hpp"
+#include "StringPool.hpp"
+#include "TokenMatcher.hpp"
+
+#define BENCH_USAGE_MSG "Usage: spam_bench [--entries <count>] [--min-word <length>] " \
+                        "[--max-word <length>] [--max-words <count>] [--multi-word <share>] " \
+                        "[--messages <count>] [--message-size <bytes>] [--hit-density <share>] " \
+                        "[--repeat <count>] [--seed <seed>] [--max-threads <count>]"
+#define DICTIONARY_FILE_NAME "dictionary.csv"
+#define MESSAGE_FILE_PREFIX "message"
+#define TEMP_DIR_PATTERN "spam_bench-%%%%-%%%%"
+
+const double BYTES_IN_MB = 1024.0 * 1024.0;
+const int MAX_SCORE = 10;
+const int BENCH_THRESHOLD = 50;
+const int WORDS_PER_LINE = 12;
+const double UPPER_CASE_SHARE = 0.1;
+const size_t FOLD_PASSES = 8;
+//the number of phrases the hit counters are spread over, few enough for threads to collide
+const size_t CONTENDED_PHRASES = 256;
+
+/**
+ * @brief the shape of the generated dictionary and messages
+ */
+struct BenchConfig
+{
+    size_t entries = 100000;
+    size_t minWordLength = 3;
+    size_t maxWordLength = 10;
+    size_t maxPhraseWords = 3;
+    double multiWordShare = 0.3;
+    size_t messageCount = 200;
+    size_t messageSize = 64 * 1024;
+    double hitDensity = 0.01;
+    size_t repetitions = 3;
+    unsigned seed = 1;
+    size_t maxThreads = 64;
+};
+
+/**
+ * @brief the measurement of a single benchmark
+ */
+struct BenchResult
+{
+    std::string name;
+    double seconds;
+    double bytes;
+    double items;
+    std::string unit;
+};
+
+/**
+ * @brief the layout HashMap had before it moved to a flat table, a vector of pairs per bucket,
+ * kept only as a baseline for the map benchmarks. like the old map, a lookup copies the bucket
+ * and at looks the key up twice
+ * @tparam KeyT the key of a pair in the map
+ * @tparam ValueT the value of the said pair
+ */
+template <typename KeyT, typename ValueT>
+class ChainedMap
+{
+public:
+    /**
+     * @brief default constructor for this class
+     */
+    ChainedMap() : _buckets(START_CAPACITY), _size(0)
+    {
+    }
+
+    /**
+     * @brief inserts a pair, growing the map past the upper load factor
+     * @param key the key of the pair
+     * @param value the value of the pair
+     * @return true if the pair was inserted, false if the key was already in the map
+     */
+    bool insert(const KeyT &key, const ValueT &value)
+    {
+        if (containsKey(key))
+        {
+            return false;
+        }
+        _buckets[_bucketOf(key, _buckets.size())].emplace_back(key, value);
+        _size++;
+        if ((double) _size / _buckets.size() > DEFAULT_UPPER_LOAD_FACTOR)
+        {
+            _grow();
+        }
+        return true;
+    }
+
+    /**
+     * @param key the key to check if it's contained
+     * @return true if it's contained, false otherwise
+     */
+    bool containsKey(const KeyT &key) const
+    {
+        return _innerIdx(key) != ERROR_CODE;
+    }
+
+    /**
+     * @param key the key of the value
+     * @return the value matching to the key
+     */
+    ValueT at(const KeyT &key) const
+    {
+        if (!containsKey(key))
+        {
+            throw std::invalid_argument(NONEXISTANT_KEY_ERR);
+        }
+        return _buckets[_bucketOf(key, _buckets.size())][_innerIdx(key)].second;
+    }
+
+    /**
+     * @return the bytes of the bucket array and of every bucket, not counting the allocator's
+     * own overhead for every bucket
+     */
+    size_t bytesAllocated() const
+    {
+        size_t bytes = _buckets.capacity() * sizeof(_buckets[0]);
+        for (const auto &bucket : _buckets)
+        {
+            bytes += bucket.capacity() * sizeof(std::pair<KeyT, ValueT>);
+        }
+        return bytes;
+    }
+
+private:
+    std::vector<std::vector<std::pair<KeyT, ValueT>>> _buckets;
+    int _size;
+
+    /**
+     * @param key the key to hash
+     * @param bucketCount the number of buckets
+     * @return the bucket of the key
+     */
+    static size_t _bucketOf(const KeyT &key, size_t bucketCount)
+    {
+        return std::hash<KeyT>{} (key) & (bucketCount - 1);
+    }
+
+    /**
+     * @param key the key to look for
+     * @return the index of the key in its bucket, or the error code if it's not there
+     */
+    int _innerIdx(const KeyT &key) const
+    {
+        std::vector<std::pair<KeyT, ValueT>> bucket = _buckets[_bucketOf(key, _buckets.size())];
+        for (size_t pairIdx = 0; pairIdx < bucket.size(); pairIdx++)
+        {
+            if (bucket[pairIdx].first == key)
+            {
+                return (int) pairIdx;
+            }
+        }
+        return ERROR_CODE;
+    }
+
+    /**
+     * @brief doubles the buckets until the load factor is back in range, copying every pair
+     */
+    void _grow()
+    {
+        size_t bucketCount = _buckets.size();
+        while ((double) _size / bucketCount > DEFAULT_UPPER_LOAD_FACTOR)
+        {
+            bucketCount *= RESIZE_FACTOR;
+        }
+        std::vector<std::vector<std::pair<KeyT, ValueT>>> grown(bucketCount);
+        for (const auto &bucket : _buckets)
+        {
+            for (const auto &pair : bucket)
+            {
+                grown[_bucketOf(pair.first, bucketCount)].push_back(pair);
+            }
+        }
+        _buckets.swap(grown);
+    }
+};
+
+/**
+ * @brief generates a random word
+ * @param config the shape of the words
+ * @param random the random generator
+ * @return the word, sometimes with upper case letters
+ */
+std::string generateWord(const BenchConfig &config, std::mt19937 &random)
+{
+    std::uniform_int_distribution<size_t> length(config.minWordLength, config.maxWordLength);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::bernoulli_distribution upperCase(UPPER_CASE_SHARE);
+    std::string word(length(random), ' ');
+    for (auto &c : word)
+    {
+        c = (char) letter(random);
+        if (upperCase(random))
+        {
+            c = (char) std::toupper(c);
+        }
+    }
+    return word;
+}
+
+/**
+ * @brief generates the phrases of a dictionary
+ * @param config the shape of the dictionary
+ * @param random the random generator
+ * @return the phrases, multi word phrases have words separated by single spaces
+ */
+std::vector<std::string> generatePhrases(const BenchConfig &config, std::mt19937 &random)
+{
+    std::bernoulli_distribution multiWord(config.multiWordShare);
+    std::uniform_int_distribution<size_t> wordCount(2, std::max<size_t>(2, config.maxPhraseWords));
+    std::vector<std::string> phrases;
+    phrases.reserve(config.entries);
+    for (size_t entryIdx = 0; entryIdx < config.entries; entryIdx++)
+    {
+        std::string phrase = generateWord(config, random);
+        if (config.maxPhraseWords > 1 && multiWord(random))
+        {
+            for (size_t words = wordCount(random); words > 1; words--)
+            {
+                phrase += ' ' + generateWord(config, random);
+            }
+        }
+        phrases.push_back(phrase);
+    }
+    return phrases;
+}
+
+/**
+ * @brief writes a dictionary file with random scores
+ * @param phrases the phrases of the dictionary
+ * @param filePath the path to write to
+ * @param random the random generator
+ * @return the size of the file in bytes
+ */
+size_t writeDictionary(const std::vector<std::string> &phrases, const std::string &filePath,
+                       std::mt19937 &random)
+{
+    std::uniform_int_distribution<int> score(0, MAX_SCORE);
+    std::ofstream fileWriter(filePath);
+    for (const auto &phrase : phrases)
+    {
+        fileWriter << phrase << ',' << score(random) << '\n';
+    }
+    return (size_t) fileWriter.tellp();
+}
+
+/**
+ * @brief generates a message of random words with dictionary phrases mixed in
+ * @param config the size of the message and the share of dictionary phrases
+ * @param phrases the phrases of the dictionary
+ * @param random the random generator
+ * @return the message
+ */
+std::string generateMessage(const BenchConfig &config, const std::vector<std::string> &phrases,
+                            std::mt19937 &random)
+{
+    std::bernoulli_distribution hit(config.hitDensity);
+    std::uniform_int_distribution<size_t> phraseIdx(0, phrases.size() - 1);
+    std::string message;
+    message.reserve(config.messageSize + config.maxWordLength * config.maxPhraseWords);
+    size_t wordsInLine = 0;
+    while (message.size() < config.messageSize)
+    {
+        message += hit(random) && !phrases.empty() ? phrases[phraseIdx(random)] :
+                   generateWord(config, random);
+        message += ++wordsInLine % WORDS_PER_LINE == 0 ? '\n' : ' ';
+    }
+    return message;
+}
+
+/**
+ * @brief runs a benchmark a few times and keeps the fastest run
+ * @param config the number of runs
+ * @param name the name of the benchmark
+ * @param bytes the bytes processed by a run
+ * @param items the items processed by a run
+ * @param unit the name of the items
+ * @param setup prepares a run, not timed
+ * @param run the timed work
+ * @return the measurement
+ */
+BenchResult measure(const BenchConfig &config, const std::string &name, double bytes,
+                    double items, const std::string &unit, const std::function<void()> &setup,
+                    const std::function<void()> &run)
+{
+    double bestSeconds = -1;
+    for (size_t repetition = 0; repetition < std::max<size_t>(1, config.repetitions); repetition++)
+    {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        run();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                       start).count();
+        if (bestSeconds < 0 || seconds < bestSeconds)
+        {
+            bestSeconds = seconds;
+        }
+    }
+    return BenchResult{name, bestSeconds, bytes, items, unit};
+}
+
+/**
+ * @brief runs work on a number of threads at once and waits for all of them
+ * @param threadCount the number of threads
+ * @param work called on every thread with its index
+ */
+void runThreads(size_t threadCount, const std::function<void(size_t)> &work)
+{
+    std::vector<std::thread> threads;
+    for (size_t threadIdx = 0; threadIdx < threadCount; threadIdx++)
+    {
+        threads.emplace_back(work, threadIdx);
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+/**
+ * @brief prints the measurements as a single json object
+ * @param config the shape of the generated data
+ * @param results the measurements
+ * @param mapStats the layout of the map built from the dictionary
+ * @param chainedBytes the bytes the chained layout takes for the same dictionary
+ */
+void printResults(const BenchConfig &config, const std::vector<BenchResult> &results,
+                  const HashMapStats &mapStats, size_t chainedBytes)
+{
+    std::cout << "{\"config\":{\"entries\":" << config.entries
+              << ",\"min_word\":" << config.minWordLength
+              << ",\"max_word\":" << config.maxWordLength
+              << ",\"max_words\":" << config.maxPhraseWords
+              << ",\"multi_word\":" << config.multiWordShare
+              << ",\"messages\":" << config.messageCount
+              << ",\"message_size\":" << config.messageSize
+              << ",\"hit_density\":" << config.hitDensity
+              << ",\"repeat\":" << config.repetitions
+              << ",\"seed\":" << config.seed
+              << ",\"max_threads\":" << config.maxThreads << "},\"hashmap\":";
+    writeMapStats(std::cout, mapStats);
+    std::cout << ",\"chained_bytes\":" << chainedBytes;
+    std::cout << ",\"results\":[";
+    for (size_t resultIdx = 0; resultIdx < results.size(); resultIdx++)
+    {
+        const BenchResult &result = results[resultIdx];
+        double seconds = std::max(result.seconds, 1e-12);
+        std::cout << (resultIdx == 0 ? "" : ",") << "\n{\"name\":\"" << result.name
+                  << "\",\"seconds\":" << result.seconds
+                  << ",\"bytes\":" << result.bytes
+                  << ",\"mb_per_s\":" << result.bytes / BYTES_IN_MB / seconds
+                  << ",\"items\":" << result.items
+                  << ",\"unit\":\"" << result.unit
+                  << "\",\"items_per_s\":" << result.items / seconds << "}";
+    }
+    std::cout << "\n]}" << std::endl;
+}
+
+/**
+ * @brief reads the command line options into a config
+ * @param argc the number of arguments
+ * @param argv the arguments
+ * @param config the config to fill
+ * @return true if all options were valid, false otherwise
+ */
+bool parseConfig(int argc, char *argv[], BenchConfig &config)
+{
+    for (int argIdx = 1; argIdx < argc; argIdx += 2)
+    {
+        if (argIdx + 1 == argc)
+        {
+            return false;
+        }
+        std::string name = argv[argIdx];
+        std::string value = argv[argIdx + 1];
+        if (name == "--entries") config.entries = std::stoul(value);
+        else if (name == "--min-word") config.minWordLength = std::stoul(value);
+        else if (name == "--max-word") config.maxWordLength = std::stoul(value);
+        else if (name == "--max-words") config.maxPhraseWords = std::stoul(value);
+        else if (name == "--multi-word") config.multiWordShare = std::stod(value);
+        else if (name == "--messages") config.messageCount = std::stoul(value);
+        else if (name == "--message-size") config.messageSize = std::stoul(value);
+        else if (name == "--hit-density") config.hitDensity = std::stod(value);
+        else if (name == "--repeat") config.repetitions = std::stoul(value);
+        else if (name == "--seed") config.seed = (unsigned) std::stoul(value);
+        else if (name == "--max-threads") config.maxThreads = std::stoul(value);
+        else return false;
+    }
+    return config.minWordLength > 0 && config.minWordLength <= config.maxWordLength &&
+           config.maxThreads > 0;
+}
+
+/**
+ * @brief generates a dictionary and messages, and times loading, building and scoring them.
+ * prints the results as json, so runs can be compared between releases
+ * @param argc the number of arguments
+ * @param argv the arguments
+ * @return 0 upon success completion, exit failure constant otherwise
+ */
+int main(int argc, char *argv[])
+{
+    BenchConfig config;
+    try
+    {
+        if (!parseConfig(argc, argv, config))
+        {
+            std::cerr << BENCH_USAGE_MSG << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception &)
+    {
+        std::cerr << BENCH_USAGE_MSG << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::mt19937 random(config.seed);
+    boost::filesystem::path tempDir = boost::filesystem::temp_directory_path() /
+                                      boost::filesystem::unique_path(TEMP_DIR_PATTERN);
+    boost::filesystem::create_directories(tempDir);
+    std::vector<BenchResult> results;
+
+    //generated data
+    std::vector<std::string> phrases = generatePhrases(config, random);
+    std::string dictionaryPath = (tempDir / DICTIONARY_FILE_NAME).string();
+    size_t dictionarySize = writeDictionary(phrases, dictionaryPath, random);
+    std::vector<std::string> messagePaths;
+    std::string allMessages;
+    for (size_t messageIdx = 0; messageIdx < config.messageCount; messageIdx++)
+    {
+        std::string message = generateMessage(config, phrases, random);
+        messagePaths.push_back((tempDir / (MESSAGE_FILE_PREFIX + std::to_string(messageIdx)))
+                                       .string());
+        std::ofstream(messagePaths.back()) << message;
+        allMessages += message;
+    }
+
+    //database loading and map building
+    StringPool phrasePool;
+    std::vector<std::string_view> words;
+    std::vector<int> scores;
+    results.push_back(measure(config, "db_load", dictionarySize, config.entries, "entries", [&]
+    {
+        words.clear();
+        scores.clear();
+        phrasePool = StringPool();
+    }, [&]
+    {
+        readFileIntoVectors(words, scores, phrasePool, dictionaryPath);
+    }));
+    std::vector<std::string_view> buildWords;
+    std::vector<int> buildScores;
+    std::unique_ptr<HashMap<std::string_view, int>> scoreMap;
+    results.push_back(measure(config, "hashmap_build", 0, config.entries, "entries", [&]
+    {
+        scoreMap.reset();
+        buildWords = words;
+        buildScores = scores;
+    }, [&]
+    {
+        scoreMap.reset(new HashMap<std::string_view, int>(std::move(buildWords),
+                                                          std::move(buildScores)));
+    }));
+
+    HashMapStats mapStats = scoreMap->stats();
+
+    //map lookups and iteration
+    std::vector<std::string> misses;
+    for (size_t missIdx = 0; missIdx < words.size(); missIdx++)
+    {
+        misses.push_back(std::string(words[missIdx]) + '#');
+    }
+    long checksum = 0;
+    results.push_back(measure(config, "hashmap_lookup_hit", 0, words.size(), "lookups", [] {}, [&]
+    {
+        for (const auto &word : words)
+        {
+            checksum += scoreMap->find(word)->second;
+        }
+    }));
+    results.push_back(measure(config, "hashmap_lookup_miss", 0, misses.size(), "lookups", [] {},
+                              [&]
+    {
+        for (const auto &miss : misses)
+        {
+            checksum += scoreMap->containsKey(miss);
+        }
+    }));
+    results.push_back(measure(config, "hashmap_iterate", 0, scoreMap->size(), "entries", [] {}, [&]
+    {
+        for (const auto &pair : *scoreMap)
+        {
+            checksum += pair.second;
+        }
+    }));
+
+    //the same lookups in the chained layout the map had before, for comparing time and memory
+    std::unique_ptr<ChainedMap<std::string_view, int>> chainedMap;
+    results.push_back(measure(config, "chained_build", 0, config.entries, "entries", [&]
+    {
+        chainedMap.reset();
+    }, [&]
+    {
+        chainedMap.reset(new ChainedMap<std::string_view, int>());
+        for (size_t wordIdx = 0; wordIdx < words.size(); wordIdx++)
+        {
+            chainedMap->insert(words[wordIdx], scores[wordIdx]);
+        }
+    }));
+    results.push_back(measure(config, "chained_lookup_hit", 0, words.size(), "lookups", [] {}, [&]
+    {
+        for (const auto &word : words)
+        {
+            checksum += chainedMap->at(word);
+        }
+    }));
+    results.push_back(measure(config, "chained_lookup_miss", 0, misses.size(), "lookups", [] {},
+                              [&]
+    {
+        for (const auto &miss : misses)
+        {
+            checksum += chainedMap->containsKey(miss);
+        }
+    }));
+
+    //the concurrent map from a single thread up to the most threads, building it, merging maps
+    //built by every thread into it, looking it up, and counting hits of a few phrases in it
+    //against a single map behind a lock
+    for (size_t threadCount = 1; threadCount <= config.maxThreads; threadCount *= 2)
+    {
+        std::string suffix = "_t" + std::to_string(threadCount);
+        std::unique_ptr<ConcurrentHashMap<std::string_view, int>> concurrentMap;
+        results.push_back(measure(config, "concurrent_insert" + suffix, 0, words.size(),
+                                  "entries", [&]
+        {
+            concurrentMap.reset(new ConcurrentHashMap<std::string_view, int>());
+        }, [&]
+        {
+            runThreads(threadCount, [&](size_t threadIdx)
+            {
+                for (size_t wordIdx = threadIdx; wordIdx < words.size(); wordIdx += threadCount)
+                {
+                    concurrentMap->insert(words[wordIdx], scores[wordIdx]);
+                }
+            });
+        }));
+        std::vector<HashMap<std::string_view, int>> threadMaps;
+        results.push_back(measure(config, "concurrent_merge" + suffix, 0, words.size(),
+                                  "entries", [&]
+        {
+            concurrentMap.reset(new ConcurrentHashMap<std::string_view, int>());
+            threadMaps.clear();
+            for (size_t threadIdx = 0; threadIdx < threadCount; threadIdx++)
+            {
+                std::vector<std::string_view> threadWords;
+                std::vector<int> threadScores;
+                for (size_t wordIdx = threadIdx; wordIdx < words.size(); wordIdx += threadCount)
+                {
+                    threadWords.push_back(words[wordIdx]);
+                    threadScores.push_back(scores[wordIdx]);
+                }
+                threadMaps.emplace_back(std::move(threadWords), std::move(threadScores));
+            }
+        }, [&]
+        {
+            runThreads(threadCount, [&](size_t threadIdx)
+            {
+                concurrentMap->merge(threadMaps[threadIdx], [](int &score, int other)
+                {
+                    score += other;
+                });
+            });
+        }));
+        results.push_back(measure(config, "concurrent_lookup" + suffix, 0, words.size(),
+                                  "lookups", [] {}, [&]
+        {
+            std::atomic<long> found(0);
+            runThreads(threadCount, [&](size_t threadIdx)
+            {
+                long threadFound = 0;
+                for (size_t wordIdx = threadIdx; wordIdx < words.size(); wordIdx += threadCount)
+                {
+                    threadFound += *concurrentMap->find(words[wordIdx]);
+                }
+                found += threadFound;
+            });
+            checksum += found;
+        }));
+        ConcurrentHashMap<std::string_view, std::atomic<long>> hitCounters;
+        HashMap<std::string_view, long> lockedCounters;
+        std::mutex countersLock;
+        for (size_t wordIdx = 0; wordIdx < std::min(words.size(), CONTENDED_PHRASES); wordIdx++)
+        {
+            hitCounters.try_emplace(words[wordIdx], 0);
+            lockedCounters.insert(words[wordIdx], 0);
+        }
+        results.push_back(measure(config, "concurrent_count" + suffix, 0, words.size(), "hits",
+                                  [] {}, [&]
+        {
+            runThreads(threadCount, [&](size_t threadIdx)
+            {
+                for (size_t wordIdx = threadIdx; wordIdx < words.size(); wordIdx += threadCount)
+                {
+                    hitCounters.find(words[wordIdx % CONTENDED_PHRASES])->fetch_add(
+                            1, std::memory_order_relaxed);
+                }
+            });
+        }));
+        results.push_back(measure(config, "locked_count" + suffix, 0, words.size(), "hits",
+                                  [] {}, [&]
+        {
+            runThreads(threadCount, [&](size_t threadIdx)
+            {
+                for (size_t wordIdx = threadIdx; wordIdx < words.size(); wordIdx += threadCount)
+                {
+                    std::lock_guard<std::mutex> guard(countersLock);
+                    lockedCounters.find(words[wordIdx % CONTENDED_PHRASES])->second++;
+                }
+            });
+        }));
+    }
+
+    //scoring
+    std::unique_ptr<PhraseMatcher> matcher;
+    results.push_back(measure(config, "matcher_build", 0, scoreMap->size(), "entries", [&]
+    {
+        matcher.reset();
+    }, [&]
+    {
+        matcher.reset(new PhraseMatcher(*scoreMap));
+    }));
+    results.push_back(measure(config, "is_spam", allMessages.size(), config.messageCount,
+                              "messages", [] {}, [&]
+    {
+        for (const auto &messagePath : messagePaths)
+        {
+            checksum += isSpam(*matcher, messagePath, BENCH_THRESHOLD);
+        }
+    }));
+
+    results.push_back(measure(config, "score_full", allMessages.size(), config.messageCount,
+                              "messages", [] {}, [&]
+    {
+        PhraseMatcher::ScanState scanState(*matcher);
+        for (const auto &messagePath : messagePaths)
+        {
+            checksum += scoreMessage(*matcher, messagePath, scanState) >= BENCH_THRESHOLD;
+        }
+    }));
+
+    //whole word matching, against the substring scan above
+    std::unique_ptr<TokenMatcher> tokenMatcher;
+    results.push_back(measure(config, "token_build", 0, scoreMap->size(), "entries", [&]
+    {
+        tokenMatcher.reset();
+    }, [&]
+    {
+        tokenMatcher.reset(new TokenMatcher(*scoreMap));
+    }));
+    results.push_back(measure(config, "score_tokens", allMessages.size(), config.messageCount,
+                              "messages", [] {}, [&]
+    {
+        TokenMatcher::ScanState scanState(*tokenMatcher);
+        for (const auto &messagePath : messagePaths)
+        {
+            checksum += scoreMessage(*tokenMatcher, messagePath, scanState) >= BENCH_THRESHOLD;
+        }
+    }));
+
+    //case folding, against the std::tolower loop it replaced
+    std::string foldBuffer;
+    results.push_back(measure(config, "fold_tolower", allMessages.size() * FOLD_PASSES,
+                              FOLD_PASSES, "passes", [&] { foldBuffer = allMessages; }, [&]
+    {
+        for (size_t pass = 0; pass < FOLD_PASSES; pass++)
+        {
+            std::transform(foldBuffer.begin(), foldBuffer.end(), foldBuffer.begin(),
+                           [](unsigned char c)
+                           { return std::tolower(c); });
+        }
+    }));
+    results.push_back(measure(config, "fold_scalar", allMessages.size() * FOLD_PASSES,
+                              FOLD_PASSES, "passes", [&] { foldBuffer = allMessages; }, [&]
+    {
+        for (size_t pass = 0; pass < FOLD_PASSES; pass++)
+        {
+            foldAsciiLowerScalar(foldBuffer.data(), &foldBuffer[0], foldBuffer.size());
+        }
+    }));
+    results.push_back(measure(config, "fold_simd", allMessages.size() * FOLD_PASSES,
+                              FOLD_PASSES, "passes", [&] { foldBuffer = allMessages; }, [&]
+    {
+        for (size_t pass = 0; pass < FOLD_PASSES; pass++)
+        {
+            foldAsciiLower(foldBuffer.data(), &foldBuffer[0], foldBuffer.size());
+        }
+    }));
+
+    boost::filesystem::remove_all(tempDir);
+    printResults(config, results, mapStats, chainedMap->bytesAllocated());
+    std::cerr << "checksum " << checksum << std::endl; //keeps the timed loops from being dropped
+    return 0;
+}
@@ -3,35 +3,62 @@
 #include <cstring>
 #include <cmath>
 #include <boost/algorithm/string.hpp>
-#include <sstream>
 #include <fstream>
 #include <algorithm>
+#include <thread>
+#include <iterator>
+#include <sys/stat.h>
 #include "HashMap.hpp"
+#include "PhraseMatcher.hpp"
+#include "MessageSource.hpp"
+#include "WorkStealingPool.hpp"
+#include "DictionaryFile.hpp"
+#include "MessageScanner.hpp"
+#include "RunStats.hpp"
+#include "ScoreService.hpp"
+#include "MappedFile.hpp"
+#include "BakedDictionary.hpp"
+#include "TokenMatcher.hpp"
+#include "Scorer.hpp"
+#include "BatchRunner.hpp"
 
 #define ARG_NUM_ERROR_MSG "Usage: SpamDetector <database path> <message path> <threshold>"
+#define BATCH_USAGE_MSG "Usage: SpamDetector batch [--threads <count>] <database path> " \
+                        "<threshold> <message path | directory | @manifest>..."
+#define COMPILE_USAGE_MSG "Usage: SpamDetector compile <database path> <output path>"
+#define SERVE_USAGE_MSG "Usage: SpamDetector serve <database path> <socket path>"
+#define CLIENT_USAGE_MSG "Usage: SpamDetector client <socket path> <message path> <threshold>"
+#define BATCH_COMMAND "batch"
+#define COMPILE_COMMAND "compile"
+#define SERVE_COMMAND "serve"
+#define CLIENT_COMMAND "client"
+#define THREADS_OPTION "--threads"
+#define VERIFY_OPTION "--verify"
+#define STATS_OPTION "--stats"
+#define FULL_SCORE_OPTION "--full-score"
+#define PARALLEL_CUTOFF_OPTION "--parallel-cutoff"
+#define TOKENS_OPTION "--tokens"
 #define GENERAL_ERROR "Invalid input"
 
-const int ARG_NUMBER = 4;
-const int INPUT_DB_IDX = 1;
-const int INPUT_MESSAGE_IDX = 2;
-const int INPUT_THRESHOLD_IDX = 3;
-const int WORD_LINE_IDX = 0;
-const int SCORE_LINE_IDX = 1;
-const int LINE_LENGTH = 2;
-const int START_SCORE = 0;
-const char SPAM_MESSAGE[] = "SPAM";
-const char NOT_SPAM_MESSAGE[] = "NOT_SPAM";
-
-/**
- * @brief converts a string to lower case in place
- * @param convertedString the string to convert
- */
-void lowerString(std::string &convertedString)
-{
-    std::transform(convertedString.begin(), convertedString.end(), convertedString.begin(),
-                   [](unsigned char c)
-                   { return std::tolower(c); });
-}
+const size_t ARG_NUMBER = 3;
+const int INPUT_DB_IDX = 0;
+const int INPUT_MESSAGE_IDX = 1;
+const int INPUT_THRESHOLD_IDX = 2;
+const size_t BATCH_MIN_ARG_NUMBER = 3;
+const int BATCH_DB_IDX = 0;
+const int BATCH_THRESHOLD_IDX = 1;
+const int BATCH_FIRST_MESSAGE_IDX = 2;
+const size_t COMPILE_ARG_NUMBER = 2;
+const int COMPILE_DB_IDX = 0;
+const int COMPILE_OUTPUT_IDX = 1;
+const size_t SERVE_ARG_NUMBER = 2;
+const int SERVE_DB_IDX = 0;
+const int SERVE_SOCKET_IDX = 1;
+const size_t CLIENT_ARG_NUMBER = 3;
+const int CLIENT_SOCKET_IDX = 0;
+const int CLIENT_MESSAGE_IDX = 1;
+const int CLIENT_THRESHOLD_IDX = 2;
+const int COMMAND_IDX = 0;
 
 /**
  * @brief checks if a string is a non negative integer
@@ -58,117 +85,443 @@ bool isNonNegNumber(const std::string &checkedString)
 }
 
 /**
- * @brief splits a string into values using a delimeter
- * @param strToSplit the string to split
- * @param delimeter delimeter to seperate between values
- * @return the string split
+ * @brief method to use after an exception arises. prints error message to the user
+ */
+int exitError(const std::string& errorMessage)
+{
+    std::cerr << errorMessage << std::endl;
+    return EXIT_FAILURE;
+}
+
+/**
+ * @brief the options shared by all the commands
  */
+struct DetectorOptions
+{
+    size_t threadCount;
+    bool verifyDictionary;
+    //score messages to the end and print the score, instead of stopping at the threshold
+    bool fullScore;
+    //messages of at least this many bytes are split between the threads
+    size_t parallelCutoff;
+    //match phrases by whole words instead of substrings, only when checking a single message
+    bool tokenMode;
+};
 
-std::vector<std::string> splitString(const std::string &strToSplit, const char delimeter)
+/**
+ * @brief builds the scoring structures of a database. the baked database path names the
+ * dictionary compiled into the binary, anything else is loaded by the library
+ * @param dbPath the database to read from
+ * @param options the options of the run
+ * @param stats the stats of the run
+ * @return the compiled matcher of the database phrases
+ */
+PhraseMatcher loadMatcher(const std::string &dbPath, const DetectorOptions &options,
+                          RunStats &stats)
 {
-    std::stringstream stringStream(strToSplit);
-    std::string item;
-    std::vector<std::string> splittedStrings;
-    while (std::getline(stringStream, item, delimeter))
+    if (dbPath == BAKED_DATABASE_PATH)
     {
-        splittedStrings.push_back(item);
+        RunStats::PhaseTimer timer(stats, RunStats::PHASE_DB_LOAD);
+        PhraseMatcher matcher = bakedMatcher();
+        stats.setDictionaryEntries(matcher.phraseCount());
+        return matcher;
     }
-    return splittedStrings;
+    return loadMatcher(dbPath, options.threadCount, options.verifyDictionary, stats);
 }
 
-bool validCommaAmount(std:: string &checkedString)
+/**
+ * @brief builds the whole word matcher of a csv database
+ * @param dbPath the database to read from
+ * @param options the options of the run
+ * @param stats the stats of the run
+ * @return the whole word matcher of the database phrases
+ * @throw std::invalid_argument if the database isn't a csv file
+ */
+TokenMatcher loadTokenMatcher(const std::string &dbPath, const DetectorOptions &options,
+                              RunStats &stats)
 {
-    int commaCount = 0;
-    for (char strIdx : checkedString)
+    if (dbPath == BAKED_DATABASE_PATH)
     {
-        if (strIdx == ',')
-        {
-            commaCount++;
-        }
+        throw std::invalid_argument(GENERAL_ERROR);
     }
-    return commaCount == LINE_LENGTH - 1;
+    return loadTokenMatcher(dbPath, options.threadCount, stats);
+}
+
+/**
+ * @brief checks if a file on a certain path exists
+ * @param filePath the path of the file
+ * @return true if exists, false otherwise
+ */
+bool checkFileExists(std::string filePath)
+{
+    return (bool) std::ifstream (filePath);
+}
+
+/**
+ * @brief checks if a message argument names a message that can be read
+ * @param messagePath the message argument
+ * @return true if it's an existing file or names the standard input, false otherwise
+ */
+bool checkMessageExists(const std::string &messagePath)
+{
+    return messagePath == STDIN_MESSAGE_PATH || checkFileExists(messagePath);
 }
 
 /**
- * @brief creates vectors from a file of key value pairs
- * @param words the vector to store the words in
- * @param scores the vector to store scores in
- * @param filePath the file to read from
+ * @brief checks if a database argument names a database that can be loaded
+ * @param dbPath the database argument
+ * @return true if it's an existing file, or names the baked dictionary and one was compiled in
  */
-void readFileIntoVectors(std::vector <std::string> &words, std::vector <int> &scores,
-                         std::string filePath)
+bool checkDatabaseExists(const std::string &dbPath)
 {
-    std::ifstream fileReader(filePath);
-    std::string line;
-    while (std::getline(fileReader, line))
+    return dbPath == BAKED_DATABASE_PATH ? hasBakedDictionary() : checkFileExists(dbPath);
+}
+
+/**
+ * @brief checks if a string is a positive integer
+ * @param checkedString the string to check
+ * @return true if it's a positive integer, false otherwise
+ */
+bool isPositiveNumber(const std::string &checkedString)
+{
+    return isNonNegNumber(checkedString) && std::stoi(checkedString) > 0;
+}
+
+/**
+ * @brief removes an option and its value from a list of arguments
+ * @param args the arguments to look in
+ * @param name the name of the option
+ * @param value the string to store the value of the option in
+ * @return true if the option was found, false otherwise
+ */
+bool extractOption(std::vector<std::string> &args, const std::string &name, std::string &value)
+{
+    auto option = std::find(args.begin(), args.end(), name);
+    if (option == args.end())
+    {
+        return false;
+    }
+    if (option + 1 == args.end())
+    {
+        throw std::invalid_argument(GENERAL_ERROR);
+    }
+    value = *(option + 1);
+    args.erase(option, option + 2);
+    return true;
+}
+
+/**
+ * @brief removes a flag from a list of arguments
+ * @param args the arguments to look in
+ * @param name the name of the flag
+ * @return true if the flag was found, false otherwise
+ */
+bool extractFlag(std::vector<std::string> &args, const std::string &name)
+{
+    auto flag = std::find(args.begin(), args.end(), name);
+    if (flag == args.end())
     {
-        std::vector<std::string> lineSplit = splitString(line, ',');
-        if (!(validCommaAmount(line) && lineSplit.size() == LINE_LENGTH && isNonNegNumber
-            (lineSplit[SCORE_LINE_IDX])))
+        return false;
+    }
+    args.erase(flag);
+    return true;
+}
+
+/**
+ * @brief removes the options from a list of arguments
+ * @param args the arguments to look in
+ * @return the options found, with defaults for the missing ones
+ */
+DetectorOptions extractOptions(std::vector<std::string> &args)
+{
+    DetectorOptions options;
+    std::string value;
+    options.threadCount = std::max(1u, std::thread::hardware_concurrency());
+    if (extractOption(args, THREADS_OPTION, value))
+    {
+        if (!isPositiveNumber(value))
         {
             throw std::invalid_argument(GENERAL_ERROR);
         }
-        std::string currWords = lineSplit[WORD_LINE_IDX];
-        lowerString(currWords);
-        int score = std::stoi(lineSplit[SCORE_LINE_IDX]);
-        if (score < 0)
+        options.threadCount = std::stoi(value);
+    }
+    options.verifyDictionary = extractFlag(args, VERIFY_OPTION);
+    options.fullScore = extractFlag(args, FULL_SCORE_OPTION);
+    options.tokenMode = extractFlag(args, TOKENS_OPTION);
+    options.parallelCutoff = DEFAULT_PARALLEL_CUTOFF;
+    if (extractOption(args, PARALLEL_CUTOFF_OPTION, value))
+    {
+        if (value.empty() || !isNonNegNumber(value))
         {
             throw std::invalid_argument(GENERAL_ERROR);
         }
-        words.push_back(currWords);
-        scores.push_back(score);
+        options.parallelCutoff = std::stoul(value);
     }
-    fileReader.close();
+    return options;
 }
 
 /**
- * @brief method to use after an exception arises. prints error message to the user
+ * @brief batch mode. loads the database once, scores the messages on a pool of worker threads
+ * and prints a verdict line for every message, in input order. a message that can't be read gets
+ * an error line instead of a verdict
+ * @param args the arguments of the batch command, without the program and command names
+ * @param options the options of the run
+ * @param stats the stats of the run
+ * @return 0 if all messages were checked, exit failure constant otherwise
  */
-int exitError(const std::string& errorMessage)
+int runBatch(const std::vector<std::string> &args, const DetectorOptions &options,
+             RunStats &stats)
 {
-    std::cerr << errorMessage << std::endl;
-    return EXIT_FAILURE;
+    if (args.size() < BATCH_MIN_ARG_NUMBER)
+    {
+        return exitError(BATCH_USAGE_MSG);
+    }
+    MessageSource messages(std::vector<std::string>(args.begin() + BATCH_FIRST_MESSAGE_IDX,
+                                                    args.end()));
+    {
+        RunStats::PhaseTimer timer(stats, RunStats::PHASE_ARGUMENTS);
+        if (!(checkDatabaseExists(args[BATCH_DB_IDX]) &&
+              isPositiveNumber(args[BATCH_THRESHOLD_IDX]) && messages.inputsExist()))
+        {
+            return exitError(GENERAL_ERROR);
+        }
+    }
+    BatchOptions batchOptions;
+    batchOptions.threshold = std::stoi(args[BATCH_THRESHOLD_IDX]);
+    batchOptions.threadCount = options.threadCount;
+    batchOptions.fullScore = options.fullScore;
+    batchOptions.parallelCutoff = options.parallelCutoff;
+    const PhraseMatcher matcher = loadMatcher(args[BATCH_DB_IDX], options, stats);
+    RunStats::PhaseTimer scanTimer(stats, RunStats::PHASE_SCAN);
+    return scoreBatch(matcher, messages, batchOptions, std::cout, stats) ? 0 : EXIT_FAILURE;
 }
 
 /**
- * @brief checks if a message is spam or not
- * @param scoreMap the map from words (or sentence to score)
- * @param message the message to be checked
- * @param the threshold for if a message is a spam or not
- * @return true if spam, false otherwise
+ * @brief compile mode. writes a database into a compiled dictionary, which later runs map instead
+ * of parsing
+ * @param args the arguments of the compile command, without the program and command names
+ * @param options the options of the run
+ * @param stats the stats of the run
+ * @return 0 upon success completion, exit failure constant otherwise
  */
-bool isSpam(HashMap <std::string, int> &scoreMap, std::string message, int threshold)
+int runCompile(const std::vector<std::string> &args, const DetectorOptions &options,
+               RunStats &stats)
 {
-    int message_score = START_SCORE;
-    std::ifstream fileReader(message);
-    std::string line;
-    while (std::getline(fileReader, line))
     {
-        lowerString(line);
-        for (const auto &pair : scoreMap)
+        RunStats::PhaseTimer timer(stats, RunStats::PHASE_ARGUMENTS);
+        if (args.size() != COMPILE_ARG_NUMBER)
+        {
+            return exitError(COMPILE_USAGE_MSG);
+        }
+        if (!checkDatabaseExists(args[COMPILE_DB_IDX]))
         {
-            int timesFound = 0;
-            size_t start = line.find(pair.first);
-            size_t end = std::string::npos;
-            while (start != end)
-            {
-                timesFound++;
-                start = line.find(pair.first, start + (pair.first.size()));
-            }
-            message_score += timesFound * pair.second;
+            return exitError(GENERAL_ERROR);
         }
     }
-    return message_score >= threshold;
+    writeDictionaryFile(loadMatcher(args[COMPILE_DB_IDX], options, stats),
+                        args[COMPILE_OUTPUT_IDX]);
+    return 0;
 }
 
 /**
- * @brief checks if a file on a certain path exists
- * @param filePath the path of the file
- * @return true if exists, false otherwise
+ * @brief serve mode. loads the database once and answers score requests on a unix domain socket
+ * until interrupted or terminated. the database is loaded again on SIGHUP, and when the file
+ * changes and then stays unchanged for a poll interval
+ * @param args the arguments of the serve command, without the program and command names
+ * @param options the options of the run
+ * @param stats the stats of the run
+ * @return 0 upon success completion, exit failure constant otherwise
  */
-bool checkFileExists(std::string filePath)
+int runServe(const std::vector<std::string> &args, const DetectorOptions &options,
+             RunStats &stats)
 {
-    return (bool) std::ifstream (filePath);
+    {
+        RunStats::PhaseTimer timer(stats, RunStats::PHASE_ARGUMENTS);
+        if (args.size() != SERVE_ARG_NUMBER)
+        {
+            return exitError(SERVE_USAGE_MSG);
+        }
+        if (!checkDatabaseExists(args[SERVE_DB_IDX]))
+        {
+            return exitError(GENERAL_ERROR);
+        }
+    }
+    const std::string &dbPath = args[SERVE_DB_IDX];
+    serveDatabase(dbPath, args[SERVE_SOCKET_IDX], [&](RunStats &loadStats)
+    {
+        return loadMatcher(dbPath, options, loadStats);
+    }, stats);
+    return 0;
+}
+
+/**
+ * @brief client mode. has a running server score a message and prints its verdict, the same way
+ * as checking a single message
+ * @param args the arguments of the client command, without the program and command names
+ * @return 0 upon success completion, exit failure constant otherwise
+ */
+int runClient(const std::vector<std::string> &args)
+{
+    if (args.size() != CLIENT_ARG_NUMBER)
+    {
+        return exitError(CLIENT_USAGE_MSG);
+    }
+    if (!(checkMessageExists(args[CLIENT_MESSAGE_IDX]) &&
+          isPositiveNumber(args[CLIENT_THRESHOLD_IDX])))
+    {
+        return exitError(GENERAL_ERROR);
+    }
+    std::unique_ptr<MappedFile> mapping;
+    std::string contents;
+    std::string_view message;
+    if (args[CLIENT_MESSAGE_IDX] == STDIN_MESSAGE_PATH)
+    {
+        //the request carries the length up front, so the whole message is read first
+        contents.assign(std::istreambuf_iterator<char>(std::cin),
+                        std::istreambuf_iterator<char>());
+        message = contents;
+    }
+    else
+    {
+        try
+        {
+            mapping.reset(new MappedFile(args[CLIENT_MESSAGE_IDX]));
+            message = std::string_view(mapping->data(), mapping->size());
+        }
+        catch (const std::invalid_argument &) //not a regular file, read it instead
+        {
+        }
+        if (message.empty())
+        {
+            std::ifstream fileReader(args[CLIENT_MESSAGE_IDX], std::ios::binary);
+            contents.assign(std::istreambuf_iterator<char>(fileReader),
+                            std::istreambuf_iterator<char>());
+            message = contents;
+        }
+    }
+    if (requestScore(args[CLIENT_SOCKET_IDX], message) >= std::stoi(args[CLIENT_THRESHOLD_IDX]))
+    {
+        std::cout << SPAM_VERDICT;
+    }
+    else
+    {
+        std::cout << NOT_SPAM_VERDICT;
+    }
+    std::cout << std::endl;
+    return 0;
+}
+
+/**
+ * @brief scores a single message by substrings
+ * @param dbPath the database to score with
+ * @param messagePath the message to score
+ * @param threshold the score at which the message is spam
+ * @param options the options of the run
+ * @param stats the stats of the run
+ * @return the score of the message, or just enough to reach the threshold unless the full score
+ * was asked for
+ */
+long scoreSingle(const std::string &dbPath, const std::string &messagePath, int threshold,
+                 const DetectorOptions &options, RunStats &stats)
+{
+    PhraseMatcher matcher = loadMatcher(dbPath, options, stats);
+    RunStats::PhaseTimer timer(stats, RunStats::PHASE_SCAN);
+    PhraseMatcher::ScanState scanState(matcher);
+    PhraseMatcher::ScoreLimit limit(threshold);
+    //the message is scanned on this thread and threads count - 1 workers, only if it's large
+    //enough to be split
+    struct stat messageStat;
+    std::unique_ptr<WorkStealingPool> pool;
+    std::unique_ptr<ParallelScanner> parallel;
+    if (options.threadCount > 1 && stat(messagePath.c_str(), &messageStat) == 0 &&
+        (size_t) messageStat.st_size >= options.parallelCutoff)
+    {
+        pool.reset(new WorkStealingPool(options.threadCount - 1));
+        parallel.reset(new ParallelScanner(matcher, *pool, options.parallelCutoff));
+    }
+    long score = scoreMessage(matcher, messagePath, scanState,
+                              options.fullScore ? nullptr : &limit, parallel.get());
+    stats.addScan(scanState);
+    for (size_t workerIdx = 0; parallel != nullptr && workerIdx < pool->threadCount();
+         workerIdx++)
+    {
+        if (parallel->scanStates()[workerIdx] != nullptr)
+        {
+            stats.addScan(*parallel->scanStates()[workerIdx]);
+        }
+    }
+    stats.addMessages(1);
+    return score;
+}
+
+/**
+ * @brief scores a single message by whole words
+ * @param dbPath the csv database to score with
+ * @param messagePath the message to score
+ * @param threshold the score at which the message is spam
+ * @param options the options of the run
+ * @param stats the stats of the run
+ * @return the score of the message, or just enough to reach the threshold unless the full score
+ * was asked for
+ */
+long scoreSingleByWords(const std::string &dbPath, const std::string &messagePath, int threshold,
+                        const DetectorOptions &options, RunStats &stats)
+{
+    TokenMatcher matcher = loadTokenMatcher(dbPath, options, stats);
+    RunStats::PhaseTimer timer(stats, RunStats::PHASE_SCAN);
+    TokenMatcher::ScanState scanState(matcher);
+    PhraseMatcher::ScoreLimit limit(threshold);
+    long score = scoreMessage(matcher, messagePath, scanState,
+                              options.fullScore ? nullptr : &limit);
+    stats.addScan(scanState);
+    stats.addMessages(1);
+    return score;
+}
+
+/**
+ * @brief checks a single message
+ * @param args the arguments of the software, without the program name
+ * @param options the options of the run
+ * @param stats the stats of the run
+ * @return 0 upon success completion, exit failure constant otherwise
+ */
+int runSingle(const std::vector<std::string> &args, const DetectorOptions &options,
+              RunStats &stats)
+{
+    //intial arguments check
+    {
+        RunStats::PhaseTimer timer(stats, RunStats::PHASE_ARGUMENTS);
+        if (args.size() != ARG_NUMBER)
+        {
+            return exitError(ARG_NUM_ERROR_MSG);
+        }
+        if (!(checkDatabaseExists(args[INPUT_DB_IDX]) &&
+              (checkMessageExists(args[INPUT_MESSAGE_IDX])) &&
+              isPositiveNumber(args[INPUT_THRESHOLD_IDX])))
+        {
+            return exitError(GENERAL_ERROR);
+        }
+    }
+    int threshold = std::stoi(args[INPUT_THRESHOLD_IDX]);
+    long score = options.tokenMode ?
+                 scoreSingleByWords(args[INPUT_DB_IDX], args[INPUT_MESSAGE_IDX], threshold,
+                                    options, stats) :
+                 scoreSingle(args[INPUT_DB_IDX], args[INPUT_MESSAGE_IDX], threshold, options,
+                             stats);
+    if (score >= threshold)
+    {
+        std::cout << SPAM_VERDICT;
+    }
+    else
+    {
+        std::cout << NOT_SPAM_VERDICT;
+    }
+    if (options.fullScore)
+    {
+        std::cout << VERDICT_SEPARATOR << score;
+    }
+    std::cout << std::endl;
+    return 0;
 }
 
 /**
@@ -181,36 +534,50 @@ int main(int argc, char *argv[])
 {
     try
     {
-        //intial arguments check
-        if (argc != ARG_NUMBER)
+        std::vector<std::string> args(argv + 1, argv + argc);
+        RunStats stats(extractFlag(args, STATS_OPTION));
+        DetectorOptions options;
         {
-            return exitError(ARG_NUM_ERROR_MSG);
+            RunStats::PhaseTimer timer(stats, RunStats::PHASE_ARGUMENTS);
+            options = extractOptions(args);
         }
-        if (!((checkFileExists(argv[INPUT_DB_IDX])) && (checkFileExists(argv[INPUT_MESSAGE_IDX])) &&
-            (isNonNegNumber(argv[INPUT_THRESHOLD_IDX])) && std::stoi(argv[INPUT_THRESHOLD_IDX]) >
-            0))
+        int exitCode;
+        bool isCommand = !args.empty() && (args[COMMAND_IDX] == BATCH_COMMAND ||
+                                           args[COMMAND_IDX] == COMPILE_COMMAND ||
+                                           args[COMMAND_IDX] == SERVE_COMMAND ||
+                                           args[COMMAND_IDX] == CLIENT_COMMAND);
+        if (isCommand && options.tokenMode) //whole words are only matched for a single message
         {
-            return exitError(GENERAL_ERROR);
+            exitCode = exitError(GENERAL_ERROR);
+        }
+        else if (!args.empty() && args[COMMAND_IDX] == BATCH_COMMAND)
+        {
+            exitCode = runBatch(std::vector<std::string>(args.begin() + 1, args.end()), options,
+                                stats);
+        }
+        else if (!args.empty() && args[COMMAND_IDX] == COMPILE_COMMAND)
+        {
+            exitCode = runCompile(std::vector<std::string>(args.begin() + 1, args.end()),
+                                  options, stats);
+        }
+        else if (!args.empty() && args[COMMAND_IDX] == SERVE_COMMAND)
+        {
+            exitCode = runServe(std::vector<std::string>(args.begin() + 1, args.end()), options,
+                                stats);
         }
-        //fild reading
-        std::vector <std::string> words;
-        std::vector <int> scores;
-        readFileIntoVectors(words, scores, argv[INPUT_DB_IDX]);
-        HashMap <std::string, int> wordsToScoreMap(words, scores);
-        //analyze message
-        if (isSpam(wordsToScoreMap, argv[INPUT_MESSAGE_IDX], std::stoi(argv[INPUT_THRESHOLD_IDX])))
+        else if (!args.empty() && args[COMMAND_IDX] == CLIENT_COMMAND)
         {
-            std::cout << SPAM_MESSAGE;
+            exitCode = runClient(std::vector<std::string>(args.begin() + 1, args.end()));
         }
         else
         {
-            std::cout << NOT_SPAM_MESSAGE;
+            exitCode = runSingle(args, options, stats);
         }
-        std::cout << std::endl;
+        stats.write(std::cerr);
+        return exitCode;
     }
     catch (...)
     {
         return exitError(GENERAL_ERROR);
     }
-    return 0;
-}
\ No newline at end of file
+}
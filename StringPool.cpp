@@ -0,0 +1,32 @@
+#include <algorithm>
+#include <cstring>
+#include "StringPool.hpp"
+
+StringPool::StringPool(size_t blockSize) : _blockSize(std::max<size_t>(1, blockSize)),
+                                           _next(nullptr), _left(0), _bytesAllocated(0)
+{
+}
+
+char *StringPool::allocate(size_t size)
+{
+    if (size > _left)
+    {
+        size_t blockSize = std::max(size, _blockSize);
+        //uninitialized, so the pages of a large block are only touched as they're filled
+        _blocks.emplace_back(new char[blockSize]);
+        _next = _blocks.back().get();
+        _left = blockSize;
+        _bytesAllocated += blockSize;
+    }
+    char *bytes = _next;
+    _next += size;
+    _left -= size;
+    return bytes;
+}
+
+std::string_view StringPool::add(std::string_view text)
+{
+    char *copy = allocate(text.size());
+    std::memcpy(copy, text.data(), text.size());
+    return std::string_view(copy, text.size());
+}
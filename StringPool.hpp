@@ -0,0 +1,66 @@
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+#ifndef EX3_STRINGPOOL_HPP
+#define EX3_STRINGPOOL_HPP
+
+//strings that don't fit in what's left of a block start a new one of at least this size
+const size_t DEFAULT_POOL_BLOCK_SIZE = 64 * 1024;
+
+/**
+ * @brief This class represents an arena of strings. strings are appended into large blocks
+ * instead of each getting an allocation of its own, and blocks never move, so a view of a pooled
+ * string stays valid for as long as the pool exists. everything is freed together with the pool
+ */
+class StringPool
+{
+public:
+    /**
+     * @brief constructor for this class, allocates nothing until the first string
+     * @param blockSize the smallest block to allocate
+     */
+    explicit StringPool(size_t blockSize = DEFAULT_POOL_BLOCK_SIZE);
+
+    StringPool(const StringPool &other) = delete;
+
+    StringPool(StringPool &&other) = default;
+
+    StringPool &operator=(const StringPool &other) = delete;
+
+    StringPool &operator=(StringPool &&other) = default;
+
+    /**
+     * @brief reserves contiguous bytes in the pool, to be filled by the caller. a request larger
+     * than the block size gets a block of its own, so a caller that knows the total size up front
+     * gets everything in a single buffer
+     * @param size the number of bytes
+     * @return the first of the bytes
+     */
+    char *allocate(size_t size);
+
+    /**
+     * @brief copies a string into the pool
+     * @param text the string to copy
+     * @return a view of the copy
+     */
+    std::string_view add(std::string_view text);
+
+    /**
+     * @return number of bytes allocated for the blocks of this pool
+     */
+    size_t bytesAllocated() const
+    {
+        return _bytesAllocated;
+    }
+
+private:
+    std::vector<std::unique_ptr<char[]>> _blocks;
+    size_t _blockSize;
+    char *_next;
+    size_t _left;
+    size_t _bytesAllocated;
+};
+
+#endif //EX3_STRINGPOOL_HPP
@@ -0,0 +1,61 @@
+#include <iostream>
+#include <string>
+#include <stdexcept>
+#include <cstdlib>
+
+#ifndef EX3_TESTCHECK_HPP
+#define EX3_TESTCHECK_HPP
+
+//the number of checks of the test program that failed so far
+inline int checkFailures = 0;
+
+/**
+ * @brief records a check, printing it if it failed
+ * @param passed true if the check passed
+ * @param name the name of the check
+ */
+inline void check(bool passed, const std::string &name)
+{
+    if (!passed)
+    {
+        std::cerr << "FAILED: " << name << std::endl;
+        checkFailures++;
+    }
+}
+
+/**
+ * @brief checks that a call throws std::invalid_argument
+ * @param call the call to make
+ * @param name the name of the check
+ */
+template <typename CallT>
+void checkThrows(CallT call, const std::string &name)
+{
+    bool thrown = false;
+    try
+    {
+        call();
+    }
+    catch (const std::invalid_argument &)
+    {
+        thrown = true;
+    }
+    check(thrown, name);
+}
+
+/**
+ * @brief prints the outcome of the checks
+ * @return 0 if all checks passed, exit failure constant otherwise
+ */
+inline int checkResult()
+{
+    if (checkFailures > 0)
+    {
+        std::cerr << checkFailures << " checks failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "all checks passed" << std::endl;
+    return EXIT_SUCCESS;
+}
+
+#endif //EX3_TESTCHECK_HPP
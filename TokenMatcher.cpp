@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <climits>
+#include "TokenMatcher.hpp"
+#include "CaseFold.hpp"
+
+const uint32_t PREFIX_ONLY = UINT32_MAX;
+const char LINE_END = '\n';
+const char WORD_SEPARATOR = ' ';
+const unsigned char FIRST_NON_ASCII = 0x80;
+
+namespace
+{
+    /**
+     * @param c a lower cased byte
+     * @return true if the byte is part of a word, false if it separates words
+     */
+    bool isWordByte(unsigned char c)
+    {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c >= FIRST_NON_ASCII;
+    }
+
+    /**
+     * @brief cuts lower cased text into words and writes them separated by single spaces, so any
+     * run of consecutive words is a substring of the result
+     * @param folded the lower cased text
+     * @param words the string to write the words to
+     * @param wordStarts the vector to store where every word starts in words
+     * @param wordEnds the vector to store where every word ends in words
+     */
+    void splitWords(std::string_view folded, std::string &words, std::vector<size_t> &wordStarts,
+                    std::vector<size_t> &wordEnds)
+    {
+        words.clear();
+        wordStarts.clear();
+        wordEnds.clear();
+        size_t byteIdx = 0;
+        while (true)
+        {
+            while (byteIdx < folded.size() && !isWordByte(folded[byteIdx]))
+            {
+                byteIdx++;
+            }
+            if (byteIdx == folded.size())
+            {
+                return;
+            }
+            if (!words.empty())
+            {
+                words.push_back(WORD_SEPARATOR);
+            }
+            wordStarts.push_back(words.size());
+            while (byteIdx < folded.size() && isWordByte(folded[byteIdx]))
+            {
+                words.push_back(folded[byteIdx++]);
+            }
+            wordEnds.push_back(words.size());
+        }
+    }
+}
+
+TokenMatcher::ScanState::ScanState(const TokenMatcher &matcher) :
+        _nextAllowed(matcher.phraseCount(), 0), _wordOffset(0), _offset(0), _lineCount(0),
+        _matchCount(0)
+{
+}
+
+TokenMatcher::TokenMatcher(const HashMap<std::string_view, int> &scoreMap) : _maxPhraseWords(0)
+{
+    std::string folded;
+    std::string words;
+    std::vector<size_t> wordStarts;
+    std::vector<size_t> wordEnds;
+    _entries.reserve(scoreMap.size());
+    for (const auto &pair : scoreMap)
+    {
+        folded.resize(pair.first.size());
+        foldAsciiLower(pair.first.data(), &folded[0], pair.first.size());
+        splitWords(folded, words, wordStarts, wordEnds);
+        if (wordEnds.empty()) //a phrase without words never matches
+        {
+            continue;
+        }
+        std::string_view phrase = _pool.add(words);
+        _maxPhraseWords = std::max(_maxPhraseWords, wordEnds.size());
+        for (size_t wordIdx = 0; wordIdx + 1 < wordEnds.size(); wordIdx++)
+        {
+            _entries.try_emplace(phrase.substr(0, wordEnds[wordIdx]), PREFIX_ONLY);
+        }
+        uint32_t &entry = _entries.try_emplace(phrase, PREFIX_ONLY).first->second;
+        if (entry == PREFIX_ONLY)
+        {
+            entry = (uint32_t) _phraseScore.size();
+            _phraseScore.push_back(0);
+        }
+        _phraseScore[entry] += pair.second;
+    }
+}
+
+long TokenMatcher::scoreText(std::string_view text, ScanState &state,
+                             PhraseMatcher::ScoreLimit *limit) const
+{
+    long textScore = 0;
+    long sharedScore = 0; //the part of the text score already added to the limit
+    long stopScore = LONG_MAX; //the text score at which the message reaches its threshold
+    size_t scanned = 0;
+    while (scanned < text.size() && textScore < stopScore)
+    {
+        if (limit != nullptr) //other scans of the message may have added to it since last line
+        {
+            long messageScore = limit->_add(textScore - sharedScore);
+            sharedScore = textScore;
+            stopScore = textScore + limit->_threshold - messageScore;
+            if (textScore >= stopScore)
+            {
+                break;
+            }
+        }
+        size_t lineEnd = text.find(LINE_END, scanned);
+        if (lineEnd == std::string_view::npos)
+        {
+            lineEnd = text.size();
+        }
+        _scoreLine(text.substr(scanned, lineEnd - scanned), state, textScore, stopScore);
+        state._lineCount++;
+        scanned = std::min(text.size(), lineEnd + 1);
+    }
+    if (limit != nullptr)
+    {
+        limit->_add(textScore - sharedScore);
+    }
+    state._offset += scanned;
+    return textScore;
+}
+
+void TokenMatcher::_scoreLine(std::string_view line, ScanState &state, long &textScore,
+                              long stopScore) const
+{
+    state._folded.resize(line.size());
+    foldAsciiLower(line.data(), &state._folded[0], line.size());
+    splitWords(state._folded, state._words, state._wordStarts, state._wordEnds);
+    std::string_view words = state._words;
+    size_t wordCount = state._wordStarts.size();
+    for (size_t first = 0; first < wordCount && textScore < stopScore; first++)
+    {
+        //runs of words are looked up from the shortest, until no phrase starts with the run
+        size_t last = std::min(wordCount, first + _maxPhraseWords);
+        for (size_t end = first; end < last && textScore < stopScore; end++)
+        {
+            auto entry = _entries.find(words.substr(state._wordStarts[first],
+                                                    state._wordEnds[end] -
+                                                    state._wordStarts[first]));
+            if (entry == _entries.end())
+            {
+                break;
+            }
+            uint32_t phrase = entry->second;
+            //positions are words counted over everything scanned with this state
+            if (phrase != PREFIX_ONLY && state._wordOffset + first >= state._nextAllowed[phrase])
+            {
+                state._nextAllowed[phrase] = state._wordOffset + end + 1;
+                textScore += _phraseScore[phrase];
+                state._matchCount++;
+            }
+        }
+    }
+    state._wordOffset += wordCount;
+}
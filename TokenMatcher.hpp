@@ -0,0 +1,145 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "HashMap.hpp"
+#include "PhraseMatcher.hpp"
+#include "StringPool.hpp"
+
+#ifndef EX3_TOKENMATCHER_HPP
+#define EX3_TOKENMATCHER_HPP
+
+/**
+ * @brief This class represents a dictionary of scored phrases matched by whole words instead of
+ * substrings. a line is lower cased and cut into words once, and every run of up to the longest
+ * phrase in words is looked up in a hash map, so the cost depends on the length of the message and
+ * not on the size of the dictionary.
+ * this is not the same as the substring matching of PhraseMatcher:
+ * - a word is a run of ASCII letters, digits and non ASCII bytes, anything else only separates
+ * words. phrases are cut into words the same way, so a phrase matches the same words with any
+ * separators between them: "free money" matches "Free, money" but not "freemoney" or "free moneys"
+ * - a phrase without a single word, such as "!!!", never matches
+ * - phrases that become the same words, such as "free money" and "free-money", count as one
+ * phrase scoring the sum of their scores
+ * as in substring mode, matching starts over at every line and occurrences of a phrase are
+ * counted without overlapping
+ */
+class TokenMatcher
+{
+public:
+    /**
+     * @brief per scan state of the matcher. holds for every phrase the first word at which it may
+     * be counted again, and the buffers a line is cut into words with. a state may be reused for
+     * any number of lines and messages, but not by two threads at once
+     */
+    class ScanState
+    {
+    public:
+        /**
+         * @brief constructor for this class
+         * @param matcher the matcher this state will be used with
+         */
+        explicit ScanState(const TokenMatcher &matcher);
+
+        /**
+         * @return number of bytes scanned with this state
+         */
+        uint64_t bytesScanned() const
+        {
+            return _offset;
+        }
+
+        /**
+         * @return number of lines scanned with this state, a text that doesn't end with a
+         * newline counts its last line too
+         */
+        uint64_t linesScanned() const
+        {
+            return _lineCount;
+        }
+
+        /**
+         * @return number of phrase occurrences counted with this state
+         */
+        uint64_t matchCount() const
+        {
+            return _matchCount;
+        }
+
+    private:
+        friend class TokenMatcher;
+        std::vector<uint64_t> _nextAllowed;
+        uint64_t _wordOffset;
+        uint64_t _offset;
+        uint64_t _lineCount;
+        uint64_t _matchCount;
+        std::string _folded;
+        std::string _words;
+        std::vector<size_t> _wordStarts;
+        std::vector<size_t> _wordEnds;
+    };
+
+    /**
+     * @brief cuts the phrases of a map into words and indexes them, together with every shorter
+     * run of words a phrase starts with, so a lookup stops as soon as no phrase can match
+     * @param scoreMap the map from phrases to their score. the phrases are copied, so the strings
+     * they view may be freed after
+     */
+    explicit TokenMatcher(const HashMap<std::string_view, int> &scoreMap);
+
+    TokenMatcher(const TokenMatcher &other) = delete;
+
+    TokenMatcher(TokenMatcher &&other) = default;
+
+    TokenMatcher &operator=(const TokenMatcher &other) = delete;
+
+    TokenMatcher &operator=(TokenMatcher &&other) = default;
+
+    /**
+     * @brief scores a piece of text by whole words
+     * @param text the text to score, any number of whole lines
+     * @param state the scan state to use
+     * @param limit if given, scanning stops once the message this text is part of reaches its
+     * threshold, which is checked after every match and shared with other scans every line
+     * @return the sum of the scores of all the phrases found in the text. a scan stopped by its
+     * limit returns the score it got to, which is enough to reach the threshold
+     */
+    long scoreText(std::string_view text, ScanState &state,
+                   PhraseMatcher::ScoreLimit *limit = nullptr) const;
+
+    /**
+     * @return number of phrases in this matcher, after merging phrases of the same words
+     */
+    size_t phraseCount() const
+    {
+        return _phraseScore.size();
+    }
+
+    /**
+     * @return number of words in the longest phrase
+     */
+    size_t maxPhraseWords() const
+    {
+        return _maxPhraseWords;
+    }
+
+private:
+    StringPool _pool;
+    //every phrase and every run of words a phrase starts with, to its phrase index or the prefix
+    //constant if no phrase is exactly those words
+    HashMap<std::string_view, uint32_t> _entries;
+    std::vector<long> _phraseScore;
+    size_t _maxPhraseWords;
+
+    /**
+     * @brief scores a single line, without its line end
+     * @param line the line
+     * @param state the scan state to use
+     * @param textScore the score of the text so far, added to
+     * @param stopScore the text score at which to stop
+     */
+    void _scoreLine(std::string_view line, ScanState &state, long &textScore,
+                    long stopScore) const;
+};
+
+#endif //EX3_TOKENMATCHER_HPP
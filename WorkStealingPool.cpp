@@ -0,0 +1,175 @@
+#include <algorithm>
+#include "WorkStealingPool.hpp"
+
+namespace
+{
+    /**
+     * @brief the pool the current thread works for, if any
+     */
+    thread_local const WorkStealingPool *currentPool = nullptr;
+
+    /**
+     * @brief the worker index of the current thread in its pool
+     */
+    thread_local size_t currentWorker = NOT_A_WORKER;
+
+    /**
+     * @brief the shared state of a parallel for. the helper tasks may start after the call
+     * returned, so they share ownership of it
+     */
+    struct ParallelForJob
+    {
+        size_t count;
+        const std::function<void(size_t, size_t)> *body;
+        std::atomic<size_t> next;
+        std::atomic<size_t> done;
+        std::mutex lock;
+        std::condition_variable finished;
+    };
+
+    /**
+     * @brief claims and runs indices of a parallel for until none are left
+     * @param job the parallel for
+     * @param workerIdx the worker running them
+     */
+    void runClaimed(ParallelForJob &job, size_t workerIdx)
+    {
+        for (size_t index = job.next++; index < job.count; index = job.next++)
+        {
+            (*job.body)(index, workerIdx);
+            if (++job.done == job.count)
+            {
+                std::lock_guard<std::mutex> guard(job.lock);
+                job.finished.notify_all();
+            }
+        }
+    }
+}
+
+WorkStealingPool::WorkStealingPool(size_t threadCount) : _queued(0), _nextQueue(0),
+                                                         _stopping(false)
+{
+    if (threadCount == 0)
+    {
+        threadCount = 1;
+    }
+    for (size_t workerIdx = 0; workerIdx < threadCount; workerIdx++)
+    {
+        _queues.emplace_back(new WorkerQueue());
+    }
+    for (size_t workerIdx = 0; workerIdx < threadCount; workerIdx++)
+    {
+        _workers.emplace_back(&WorkStealingPool::_workerLoop, this, workerIdx);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(_sleepLock);
+        _stopping = true;
+    }
+    _wakeUp.notify_all();
+    for (auto &worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::submit(Task task)
+{
+    size_t queueIdx;
+    if (currentPool == this)
+    {
+        queueIdx = currentWorker;
+    }
+    else
+    {
+        queueIdx = _nextQueue.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+    }
+    {
+        //counted before it's queued so the counter never drops below the real amount, and
+        //under the lock so a worker can't miss the wake up between checking and sleeping
+        std::lock_guard<std::mutex> guard(_sleepLock);
+        _queued++;
+    }
+    {
+        std::lock_guard<std::mutex> guard(_queues[queueIdx]->lock);
+        _queues[queueIdx]->tasks.push_back(std::move(task));
+    }
+    _wakeUp.notify_one();
+}
+
+void WorkStealingPool::parallelFor(size_t count, const std::function<void(size_t, size_t)> &body)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    std::shared_ptr<ParallelForJob> job = std::make_shared<ParallelForJob>();
+    job->count = count;
+    job->body = &body;
+    job->next = 0;
+    job->done = 0;
+    for (size_t helper = 0; helper < std::min(count - 1, threadCount()); helper++)
+    {
+        submit([job](size_t workerIdx)
+               { runClaimed(*job, workerIdx); });
+    }
+    runClaimed(*job, currentPool == this ? currentWorker : NOT_A_WORKER);
+    //every index is claimed, the ones still running finish on the threads that claimed them
+    std::unique_lock<std::mutex> guard(job->lock);
+    job->finished.wait(guard, [&job]
+    { return job->done == job->count; });
+}
+
+bool WorkStealingPool::_takeTask(size_t workerIdx, Task &task)
+{
+    {
+        WorkerQueue &own = *_queues[workerIdx];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            _queued--;
+            return true;
+        }
+    }
+    for (size_t offset = 1; offset < _queues.size(); offset++)
+    {
+        WorkerQueue &victim = *_queues[(workerIdx + offset) % _queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            _queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::_workerLoop(size_t workerIdx)
+{
+    currentPool = this;
+    currentWorker = workerIdx;
+    Task task;
+    while (true)
+    {
+        if (_takeTask(workerIdx, task))
+        {
+            task(workerIdx);
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(_sleepLock);
+        _wakeUp.wait(guard, [this]
+        { return _queued > 0 || _stopping; });
+        if (_queued == 0 && _stopping)
+        {
+            return;
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+#ifndef EX3_WORKSTEALINGPOOL_HPP
+#define EX3_WORKSTEALINGPOOL_HPP
+
+//the worker index given to work run by a thread that isn't a worker of the pool
+const size_t NOT_A_WORKER = SIZE_MAX;
+
+/**
+ * @brief This class represents a fixed set of worker threads, each with its own task queue.
+ * a worker runs its own newest task first and steals the oldest task of another worker when its
+ * queue is empty, so uneven tasks don't leave workers idle
+ */
+class WorkStealingPool
+{
+public:
+    /**
+     * @brief a unit of work. it receives the index of the worker running it, which is unique
+     * among the tasks running at the same time, so it may be used to pick per worker state
+     */
+    typedef std::function<void(size_t)> Task;
+
+    /**
+     * @brief constructor for this class
+     * @param threadCount the number of worker threads, at least one
+     */
+    explicit WorkStealingPool(size_t threadCount);
+
+    /**
+     * @brief d'tor for this class. runs all queued tasks and joins the workers
+     */
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &other) = delete;
+
+    WorkStealingPool &operator=(const WorkStealingPool &other) = delete;
+
+    /**
+     * @return the number of worker threads
+     */
+    size_t threadCount() const
+    {
+        return _workers.size();
+    }
+
+    /**
+     * @brief queues a task. tasks submitted from a worker go to its own queue, other tasks are
+     * spread over the workers
+     * @param task the task to run
+     */
+    void submit(Task task);
+
+    /**
+     * @brief runs a function for every index of a range and returns once all are done. the
+     * calling thread runs indices too, and while it waits it runs only indices of this call, so
+     * a task may call it without blocking its worker on unrelated work
+     * @param count the number of indices
+     * @param body the function, gets the index and the index of the worker running it, or the not
+     * a worker constant when it's run by a calling thread that isn't a worker of this pool
+     */
+    void parallelFor(size_t count, const std::function<void(size_t, size_t)> &body);
+
+private:
+    /**
+     * @brief the task queue of a single worker
+     */
+    struct WorkerQueue
+    {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> _queues;
+    std::vector<std::thread> _workers;
+    std::atomic<size_t> _queued;
+    std::atomic<size_t> _nextQueue;
+    std::mutex _sleepLock;
+    std::condition_variable _wakeUp;
+    bool _stopping;
+
+    /**
+     * @brief main loop of a worker thread
+     * @param workerIdx the index of the worker
+     */
+    void _workerLoop(size_t workerIdx);
+
+    /**
+     * @brief takes a task, from the worker's own queue first and then from the other queues
+     * @param workerIdx the index of the worker looking for work
+     * @param task the task to store the result in
+     * @return true if a task was found, false otherwise
+     */
+    bool _takeTask(size_t workerIdx, Task &task);
+};
+
+#endif //EX3_WORKSTEALINGPOOL_HPP